@@ -26,6 +26,7 @@
 #ifndef TINY_GSM_NO_GPRS
   typedef TinyGsmSim800::GsmClient TinyGsmClient;
   typedef TinyGsmSim800::GsmClientSecure TinyGsmClientSecure;
+  typedef TinyGsmSim800::GsmClientTransparent TinyGsmClientTransparent;
 #endif // TINY_GSM_NO_GPRS
 
 #elif defined(TINY_GSM_MODEM_SIM808) || defined(TINY_GSM_MODEM_SIM868)
@@ -34,6 +35,7 @@
   typedef TinyGsmSim808 TinyGsm;
   typedef TinyGsmSim808::GsmClient TinyGsmClient;
   typedef TinyGsmSim808::GsmClientSecure TinyGsmClientSecure;
+  typedef TinyGsmSim808::GsmClientTransparent TinyGsmClientTransparent;
 
 #elif defined(TINY_GSM_MODEM_UBLOX)
   #define TINY_GSM_MODEM_HAS_GPRS
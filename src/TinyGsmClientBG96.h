@@ -18,11 +18,17 @@
 
 #define TINY_GSM_MUX_COUNT 12
 
+// The driver's own URC handlers, and the matcher nodes their prefixes take
+#define TINY_GSM_URC_BUILTIN 2
+#define TINY_GSM_URC_BUILTIN_NODES 14
+
 #include <TinyGsmCommon.h>
 
 #define GSM_NL "\r\n"
 static const char GSM_OK[] TINY_GSM_PROGMEM = "OK" GSM_NL;
 static const char GSM_ERROR[] TINY_GSM_PROGMEM = "ERROR" GSM_NL;
+static const char GSM_URC_QIURC[] TINY_GSM_PROGMEM = GSM_NL "+QIURC:";
+static const char GSM_URC_QIOPEN[] TINY_GSM_PROGMEM = GSM_NL "+QIOPEN:";
 
 enum SimStatus {
   SIM_ERROR = 0,
@@ -74,6 +80,7 @@ public:
     this->mux = mux;
     sock_available = 0;
     sock_connected = false;
+    sock_opening = false;
     got_data = false;
 
     at->sockets[mux] = this;
@@ -86,24 +93,35 @@ public:
     stop();
     TINY_GSM_YIELD();
     rx.clear();
+    clearWriteError();
     sock_connected = at->modemConnect(host, port, mux);
     return sock_connected;
   }
 
   virtual int connect(IPAddress ip, uint16_t port) {
-    String host; host.reserve(16);
-    host += ip[0];
-    host += ".";
-    host += ip[1];
-    host += ".";
-    host += ip[2];
-    host += ".";
-    host += ip[3];
-    return connect(host.c_str(), port);
+    return connect(TinyGsmIpToString(ip).c_str(), port);
+  }
+
+  // Sends the open and returns once the modem took it, the outcome comes
+  // later as +QIOPEN. Start several clients this way, then wait for them all
+  // with waitConnections(), so their handshakes overlap
+  bool connectStart(const char *host, uint16_t port) {
+    if (sock_connected) {
+      stop();
+    }
+    rx.clear();
+    clearWriteError();
+    return at->modemConnectStart(host, port, mux);
+  }
+
+  // True while the outcome of connectStart() is not known yet
+  bool connecting() {
+    return sock_opening;
   }
 
   virtual void stop() {
     TINY_GSM_YIELD();
+    flushTx();
     at->sendAT(GF("+QICLOSE="), mux);
     sock_connected = false;
     at->waitResponse();
@@ -112,6 +130,18 @@ public:
 
   virtual size_t write(const uint8_t *buf, size_t size) {
     TINY_GSM_YIELD();
+    if (!sock_connected || getWriteError()) {
+      return 0;
+    }
+    if (tx.append(buf, size)) {
+      return size;
+    }
+    if (!flushTx()) {
+      return 0;
+    }
+    if (tx.append(buf, size)) {
+      return size;
+    }
     at->maintain();
     return at->modemSend(buf, size, mux);
   }
@@ -127,6 +157,7 @@ public:
 
   virtual int available() {
     TINY_GSM_YIELD();
+    flushTx();
     if (!rx.size()) {
       at->maintain();
     }
@@ -135,6 +166,7 @@ public:
 
   virtual int read(uint8_t *buf, size_t size) {
     TINY_GSM_YIELD();
+    flushTx();
     at->maintain();
     size_t cnt = 0;
     while (cnt < size) {
@@ -145,13 +177,21 @@ public:
         cnt += chunk;
         continue;
       }
-      // TODO: Read directly into user buffer?
       at->maintain();
-      if (sock_available > 0) {
-        sock_available -= at->modemRead(TinyGsmMin((uint16_t)rx.free(), sock_available), mux);
-      } else {
+      if (sock_available == 0) {
         break;
       }
+      // Large reads go straight into the caller's buffer,
+      // the fifo only keeps what a small read leaves over
+      if (size - cnt >= (size_t)rx.free()) {
+        size_t len = at->modemRead(TinyGsmMin(size - cnt, (size_t)sock_available), mux, buf);
+        sock_available -= len;
+        len = TinyGsmMin(len, size - cnt);
+        buf += len;
+        cnt += len;
+      } else {
+        sock_available -= at->modemRead(TinyGsmMin((uint16_t)rx.free(), sock_available), mux);
+      }
     }
     return cnt;
   }
@@ -164,8 +204,26 @@ public:
     return -1;
   }
 
-  virtual int peek() { return -1; } //TODO
-  virtual void flush() { at->stream.flush(); }
+  virtual int peek() {
+    flushTx();
+    if (!rx.size()) {
+      at->maintain();
+      // Refill the fifo, without taking more than it can hold
+      if (sock_available > 0) {
+        sock_available -= at->modemRead(TinyGsmMin((uint16_t)rx.free(), sock_available), mux);
+      }
+    }
+    const uint8_t* p;
+    if (rx.peek(p) > 0) {
+      return *p;
+    }
+    return -1;
+  }
+
+  virtual void flush() {
+    flushTx();
+    at->stream.flush();
+  }
 
   virtual uint8_t connected() {
     if (available()) {
@@ -182,12 +240,27 @@ public:
   String remoteIP() TINY_GSM_ATTR_NOT_IMPLEMENTED;
 
 private:
+  // Sends what write() collected, see TinyGsmTxBuffer
+  bool flushTx() {
+    if (!tx.size()) {
+      return true;
+    }
+    bool ok = sock_connected && (size_t)at->modemSend(tx.data(), tx.size(), mux) == tx.size();
+    tx.clear();
+    if (!ok) {
+      setWriteError();
+    }
+    return ok;
+  }
+
   TinyGsmBG96*  at;
   uint8_t       mux;
   uint16_t      sock_available;
   bool          sock_connected;
+  bool          sock_opening;
   bool          got_data;
   RxFifo        rx;
+  TinyGsmTxBuffer tx;
 };
 
 //============================================================================//
@@ -211,6 +284,7 @@ public:
     stop();
     TINY_GSM_YIELD();
     rx.clear();
+    clearWriteError();
     sock_connected = at->modemConnect(host, port, mux, true);
     return sock_connected;
   }
@@ -232,6 +306,26 @@ public:
     : stream(stream)
   {
     memset(sockets, 0, sizeof(sockets));
+    urcs.add(GFP(GSM_URC_QIURC), handleQiurc, this);
+    urcs.add(GFP(GSM_URC_QIOPEN), handleQiopen, this);
+  }
+
+  /*
+   * Unsolicited result codes
+   */
+
+  // The handler runs whenever a line starting with prefix arrives
+  // while the library waits for a response, e.g. in maintain()
+  bool addUrcHandler(GsmConstStr prefix, TinyGsmUrcHandler handler, void* arg = NULL) {
+    return urcs.add(prefix, handler, arg);
+  }
+
+  bool addUrcHandlers(const TinyGsmUrc* table, uint8_t count) {
+    return urcs.add(table, count);
+  }
+
+  bool removeUrcHandler(GsmConstStr prefix) {
+    return urcs.remove(prefix);
   }
 
   /*
@@ -270,15 +364,25 @@ public:
   }
 
   void maintain() {
+    // URCs first, so got_data is up to date
+    while (stream.available()) {
+      waitResponse(10, NULL, NULL);
+    }
+    bool check = false;
     for (int mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
       GsmClient* sock = sockets[mux];
+      if (sock && sock->tx.idle()) {
+        sock->flushTx();
+      }
       if (sock && sock->got_data) {
         sock->got_data = false;
         sock->sock_available = modemGetAvailable(mux);
+        // A socket without data left may have been closed
+        check |= !sock->sock_available;
       }
     }
-    while (stream.available()) {
-      waitResponse(10, NULL, NULL);
+    if (check) {
+      modemGetConnections();
     }
   }
 
@@ -505,6 +609,12 @@ public:
     return TinyGsmIpFromString(getLocalIP());
   }
 
+  // Waits until the clients started with GsmClient::connectStart() know
+  // their outcome. Returns true if all of them connected
+  bool waitConnections(uint32_t timeout = 20000L) {
+    return modemWaitConnections(-1, timeout);
+  }
+
   /*
    * Phone Call functions
    */
@@ -599,21 +709,47 @@ public:
 protected:
 
   bool modemConnect(const char* host, uint16_t port, uint8_t mux, bool ssl = false) {
-    int rsp;
-    sendAT(GF("+QIOPEN=1,"), mux, ',', GF("\"TCP"), GF("\",\""), host, GF("\","), port, GF(",0,0"));
-    rsp = waitResponse();
-
-    if (waitResponse(20000L, GF(GSM_NL "+QIOPEN:")) != 1) {
-      return false;
-    }
+    return modemConnectStart(host, port, mux, ssl) &&
+           modemWaitConnections(mux, 20000L);
+  }
 
-    if (stream.readStringUntil(',').toInt() != mux) {
-      return false;
+  // Sends QIOPEN and returns once the modem accepted it,
+  // handleQiopen() takes the outcome
+  bool modemConnectStart(const char* host, uint16_t port, uint8_t mux, bool ssl = false) {
+    GsmClient* sock = sockets[mux];
+    sendAT(GF("+QIOPEN=1,"), mux, ',', GF("\"TCP"), GF("\",\""), host, GF("\","), port, GF(",0,0"));
+    sock->sock_connected = false;
+    sock->sock_opening = (waitResponse() == 1);
+    return sock->sock_opening;
+  }
+
+  // Takes URCs until the connect of socket mux, or of all sockets if mux
+  // is negative, has an outcome. Those still pending after timeout are closed.
+  // Returns true if all of them connected
+  bool modemWaitConnections(int mux, uint32_t timeout) {
+    uint32_t start = millis();
+    for (;;) {
+      bool pending = false;
+      bool ok = true;
+      for (int i = 0; i < TINY_GSM_MUX_COUNT; i++) {
+        GsmClient* sock = sockets[i];
+        if (!sock || (mux >= 0 && i != mux)) continue;
+        if (sock->sock_opening && millis() - start >= timeout) {
+          sock->stop();
+          sock->sock_opening = false;
+        }
+        pending |= sock->sock_opening;
+        ok &= sock->sock_opening || sock->sock_connected;
+      }
+      if (!pending) {
+        return ok;
+      }
+      TinyGsmResponse data;
+      uint32_t spent = millis() - start;
+      if (waitResponse(spent < timeout ? timeout - spent : 0, data, GFP(GSM_URC_QIOPEN), NULL) == 1) {
+        handleQiopen(this, stream, data);
+      }
     }
-    // Read status
-    rsp = stream.readStringUntil('\n').toInt();
-
-    return (0 == rsp);
   }
 
   int modemSend(const void* buff, size_t len, uint8_t mux) {
@@ -623,6 +759,7 @@ protected:
     }
     stream.write((uint8_t*)buff, len);
     stream.flush();
+    TINY_GSM_STAT(sentData(mux, len));
     if (waitResponse(GF(GSM_NL "SEND OK")) != 1) {
       return 0;
     }
@@ -630,18 +767,17 @@ protected:
     return len;
   }
 
-  size_t modemRead(size_t size, uint8_t mux) {
+  // Reads up to size bytes into buf, or into the socket fifo if buf is NULL
+  size_t modemRead(size_t size, uint8_t mux, uint8_t* buf = NULL) {
+    size = TinyGsmMin(size, (size_t)1500);
     sendAT(GF("+QIRD="), mux, ',', size);
     if (waitResponse(GF("+QIRD:")) != 1) {
       return 0;
     }
     size_t len = stream.readStringUntil('\n').toInt();
 
-    for (size_t i=0; i<len; i++) {
-      while (!stream.available()) { TINY_GSM_YIELD(); }
-      char c = stream.read();
-      sockets[mux]->rx.put(c);
-    }
+    len = TinyGsmReadPayload(stream, sockets[mux]->rx, len, buf, size);
+    TINY_GSM_STAT(receivedData(mux, len));
     waitResponse();
     DBG("### READ:", mux, ",", len);
     return len;
@@ -657,12 +793,43 @@ protected:
       DBG("### STILL:", mux, "has", result);
       waitResponse();
     }
-    if (!result) {
-      sockets[mux]->sock_connected = modemGetConnected(mux);
-    }
     return result;
   }
 
+  // Updates sock_connected of all sockets from a single AT+QISTATE,
+  // which lists the open ones:
+  //   +QISTATE: 0,"TCP","151.139.237.11",80,5087,2,1,0,0,"uart1"
+  bool modemGetConnections() {
+    bool listed[TINY_GSM_MUX_COUNT] = { false };
+    sendAT(GF("+QISTATE"));
+    for (;;) {
+      int res = waitResponse(GF("+QISTATE:"), GFP(GSM_OK), GFP(GSM_ERROR));
+      if (res == 2) {
+        break;
+      }
+      if (res != 1) {
+        return false;
+      }
+      int mux = stream.readStringUntil(',').toInt();
+      streamSkipUntil(','); // Skip socket type
+      streamSkipUntil(','); // Skip remote ip
+      streamSkipUntil(','); // Skip remote port
+      streamSkipUntil(','); // Skip local port
+      int state = stream.readStringUntil(',').toInt();
+      streamSkipUntil('\n');
+      // 0 Initial, 1 Opening, 2 Connected, 3 Listening, 4 Closing
+      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT) {
+        listed[mux] = (state == 2);
+      }
+    }
+    for (int mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
+      if (sockets[mux]) {
+        sockets[mux]->sock_connected = listed[mux];
+      }
+    }
+    return true;
+  }
+
   bool modemGetConnected(uint8_t mux) {
     sendAT(GF("+QISTATE=1,"), mux);
     //+QISTATE: 0,"TCP","151.139.237.11",80,5087,4,1,0,0,"uart1"
@@ -713,14 +880,14 @@ public:
 
   template<typename... Args>
   void sendAT(Args... cmd) {
+    TINY_GSM_STAT(sent(cmd...));
     streamWrite("AT", cmd..., GSM_NL);
     stream.flush();
     TINY_GSM_YIELD();
     //DBG("### AT:", cmd...);
   }
 
-  // TODO: Optimize this!
-  uint8_t waitResponse(uint32_t timeout, String& data,
+  uint8_t waitResponse(uint32_t timeout, TinyGsmResponse& data,
                        GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
                        GsmConstStr r3=NULL, GsmConstStr r4=NULL, GsmConstStr r5=NULL)
   {
@@ -730,7 +897,7 @@ public:
     String r4s(r4); r4s.trim();
     String r5s(r5); r5s.trim();
     DBG("### ..:", r1s, ",", r2s, ",", r3s, ",", r4s, ",", r5s);*/
-    data.reserve(64);
+    matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
     int index = 0;
     unsigned long startMillis = millis();
     do {
@@ -738,62 +905,48 @@ public:
       while (stream.available() > 0) {
         int a = stream.read();
         if (a <= 0) continue; // Skip 0x00 bytes, just in case
-        data += (char)a;
-        if (r1 && data.endsWith(r1)) {
-          index = 1;
-          goto finish;
-        } else if (r2 && data.endsWith(r2)) {
-          index = 2;
+        data.push((char)a);
+        uint8_t match = matcher.feed(data);
+        if (!match) {
+          continue;
+        } else if (match <= 5) {
+          index = match;
           goto finish;
-        } else if (r3 && data.endsWith(r3)) {
-          index = 3;
-          goto finish;
-        } else if (r4 && data.endsWith(r4)) {
-          index = 4;
-          goto finish;
-        } else if (r5 && data.endsWith(r5)) {
-          index = 5;
-          goto finish;
-        } else if (data.endsWith(GF(GSM_NL "+QIURC:"))) {
-          stream.readStringUntil('\"');
-          String urc = stream.readStringUntil('\"');
-          stream.readStringUntil(',');
-          if (urc == "recv") {
-            int mux = stream.readStringUntil('\n').toInt();
-            DBG("### URC RECV:", mux);
-            if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-              sockets[mux]->got_data = true;
-            }
-          } else if (urc == "closed") {
-            int mux = stream.readStringUntil('\n').toInt();
-            DBG("### URC CLOSE:", mux);
-            if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-              sockets[mux]->sock_connected = false;
-            }
-          } else {
-            stream.readStringUntil('\n');
-          }
-          data = "";
         }
+        if (urcs.dispatch(match - 6, stream, data)) {
+          data.clear();
+        }
+        // The handler may have sent commands of its own, which loaded theirs
+        matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
       }
     } while (millis() - startMillis < timeout);
 finish:
+    TINY_GSM_STAT(received(index, index && data.endsWith(GFP(GSM_ERROR))));
     if (!index) {
       data.trim();
       if (data.length()) {
-        DBG("### Unhandled:", data);
+        DBG("### Unhandled:", data.c_str());
       }
-      data = "";
+      data.clear();
     }
     //DBG('<', index, '>');
     return index;
   }
 
+  uint8_t waitResponse(uint32_t timeout, String& data,
+                       GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
+                       GsmConstStr r3=NULL, GsmConstStr r4=NULL, GsmConstStr r5=NULL)
+  {
+    data.reserve(64);
+    TinyGsmResponse resp(data);
+    return waitResponse(timeout, resp, r1, r2, r3, r4, r5);
+  }
+
   uint8_t waitResponse(uint32_t timeout,
                        GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
                        GsmConstStr r3=NULL, GsmConstStr r4=NULL, GsmConstStr r5=NULL)
   {
-    String data;
+    TinyGsmResponse data;
     return waitResponse(timeout, data, r1, r2, r3, r4, r5);
   }
 
@@ -806,8 +959,52 @@ finish:
 public:
   Stream&       stream;
 
+#if defined(TINY_GSM_STATS)
+  // Command latencies and socket traffic, see TinyGsmStats
+  TinyGsmStats& getStats() { return stats; }
+#endif
+
 protected:
+#if defined(TINY_GSM_STATS)
+  TinyGsmStats  stats;
+#endif
   GsmClient*    sockets[TINY_GSM_MUX_COUNT];
+  TinyGsmMatcher matcher;
+  TinyGsmUrcs    urcs;
+
+  // +QIOPEN: <connectID>,<err>
+  static void handleQiopen(void* arg, Stream& stream, TinyGsmResponse& data) {
+    TinyGsmBG96* modem = static_cast<TinyGsmBG96*>(arg);
+    int mux = stream.readStringUntil(',').toInt();
+    int err = stream.readStringUntil('\n').toInt();
+    DBG("### URC OPEN:", mux, err);
+    if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux]) {
+      modem->sockets[mux]->sock_opening = false;
+      modem->sockets[mux]->sock_connected = (0 == err);
+    }
+  }
+
+  static void handleQiurc(void* arg, Stream& stream, TinyGsmResponse& data) {
+    TinyGsmBG96* modem = static_cast<TinyGsmBG96*>(arg);
+    stream.readStringUntil('\"');
+    String urc = stream.readStringUntil('\"');
+    stream.readStringUntil(',');
+    if (urc == "recv") {
+      int mux = stream.readStringUntil('\n').toInt();
+      DBG("### URC RECV:", mux);
+      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux]) {
+        modem->sockets[mux]->got_data = true;
+      }
+    } else if (urc == "closed") {
+      int mux = stream.readStringUntil('\n').toInt();
+      DBG("### URC CLOSE:", mux);
+      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux]) {
+        modem->sockets[mux]->sock_connected = false;
+      }
+    } else {
+      stream.readStringUntil('\n');
+    }
+  }
 };
 
 #endif
@@ -17,11 +17,17 @@
 
 #define TINY_GSM_MUX_COUNT 5
 
+// The driver's own URC handlers, and the matcher nodes their prefixes take
+#define TINY_GSM_URC_BUILTIN 2
+#define TINY_GSM_URC_BUILTIN_NODES 13
+
 #include <TinyGsmCommon.h>
 
 #define GSM_NL "\r\n"
 static const char GSM_OK[] TINY_GSM_PROGMEM = "OK" GSM_NL;
 static const char GSM_ERROR[] TINY_GSM_PROGMEM = "ERROR" GSM_NL;
+static const char GSM_URC_IPD[] TINY_GSM_PROGMEM = GSM_NL "+IPD,";
+static const char GSM_URC_CLOSED[] TINY_GSM_PROGMEM = "CLOSED";
 static unsigned TINY_GSM_TCP_KEEP_ALIVE = 120;
 
 // <stat> status of ESP8266 station interface
@@ -83,24 +89,18 @@ public:
     stop();
     TINY_GSM_YIELD();
     rx.clear();
+    clearWriteError();
     sock_connected = at->modemConnect(host, port, mux);
     return sock_connected;
   }
 
   virtual int connect(IPAddress ip, uint16_t port) {
-    String host; host.reserve(16);
-    host += ip[0];
-    host += ".";
-    host += ip[1];
-    host += ".";
-    host += ip[2];
-    host += ".";
-    host += ip[3];
-    return connect(host.c_str(), port);
+    return connect(TinyGsmIpToString(ip).c_str(), port);
   }
 
   virtual void stop() {
     TINY_GSM_YIELD();
+    flushTx();
     at->sendAT(GF("+CIPCLOSE="), mux);
     sock_connected = false;
     at->waitResponse();
@@ -109,6 +109,18 @@ public:
 
   virtual size_t write(const uint8_t *buf, size_t size) {
     TINY_GSM_YIELD();
+    if (!sock_connected || getWriteError()) {
+      return 0;
+    }
+    if (tx.append(buf, size)) {
+      return size;
+    }
+    if (!flushTx()) {
+      return 0;
+    }
+    if (tx.append(buf, size)) {
+      return size;
+    }
     //at->maintain();
     return at->modemSend(buf, size, mux);
   }
@@ -124,6 +136,7 @@ public:
 
   virtual int available() {
     TINY_GSM_YIELD();
+    flushTx();
     if (!rx.size() && sock_connected) {
       at->maintain();
     }
@@ -132,6 +145,7 @@ public:
 
   virtual int read(uint8_t *buf, size_t size) {
     TINY_GSM_YIELD();
+    flushTx();
     size_t cnt = 0;
     while (cnt < size) {
       size_t chunk = TinyGsmMin(size-cnt, rx.size());
@@ -158,8 +172,22 @@ public:
     return -1;
   }
 
-  virtual int peek() { return -1; } //TODO
-  virtual void flush() { at->stream.flush(); }
+  virtual int peek() {
+    flushTx();
+    if (!rx.size() && sock_connected) {
+      at->maintain();
+    }
+    const uint8_t* p;
+    if (rx.peek(p) > 0) {
+      return *p;
+    }
+    return -1;
+  }
+
+  virtual void flush() {
+    flushTx();
+    at->stream.flush();
+  }
 
   virtual uint8_t connected() {
     if (available()) {
@@ -176,10 +204,24 @@ public:
   String remoteIP() TINY_GSM_ATTR_NOT_IMPLEMENTED;
 
 private:
+  // Sends what write() collected, see TinyGsmTxBuffer
+  bool flushTx() {
+    if (!tx.size()) {
+      return true;
+    }
+    bool ok = sock_connected && (size_t)at->modemSend(tx.data(), tx.size(), mux) == tx.size();
+    tx.clear();
+    if (!ok) {
+      setWriteError();
+    }
+    return ok;
+  }
+
   TinyGsmESP8266* at;
   uint8_t         mux;
   bool            sock_connected;
   RxFifo          rx;
+  TinyGsmTxBuffer tx;
 };
 
 //============================================================================//
@@ -203,6 +245,7 @@ public:
     stop();
     TINY_GSM_YIELD();
     rx.clear();
+    clearWriteError();
     sock_connected = at->modemConnect(host, port, mux, true);
     return sock_connected;
   }
@@ -225,6 +268,26 @@ public:
     : stream(stream)
   {
     memset(sockets, 0, sizeof(sockets));
+    urcs.add(GFP(GSM_URC_IPD), handleIpd, this);
+    urcs.add(GFP(GSM_URC_CLOSED), handleClosed, this);
+  }
+
+  /*
+   * Unsolicited result codes
+   */
+
+  // The handler runs whenever a line starting with prefix arrives
+  // while the library waits for a response, e.g. in maintain()
+  bool addUrcHandler(GsmConstStr prefix, TinyGsmUrcHandler handler, void* arg = NULL) {
+    return urcs.add(prefix, handler, arg);
+  }
+
+  bool addUrcHandlers(const TinyGsmUrc* table, uint8_t count) {
+    return urcs.add(table, count);
+  }
+
+  bool removeUrcHandler(GsmConstStr prefix) {
+    return urcs.remove(prefix);
   }
 
   /*
@@ -270,6 +333,12 @@ public:
   }
 
   void maintain() {
+    for (int mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
+      GsmClient* sock = sockets[mux];
+      if (sock && sock->tx.idle()) {
+        sock->flushTx();
+      }
+    }
     waitResponse(10, NULL, NULL);
   }
 
@@ -451,6 +520,7 @@ protected:
     }
     stream.write((uint8_t*)buff, len);
     stream.flush();
+    TINY_GSM_STAT(sentData(mux, len));
     if (waitResponse(10000L, GF(GSM_NL "SEND OK" GSM_NL)) != 1) {
       return 0;
     }
@@ -492,14 +562,14 @@ public:
 
   template<typename... Args>
   void sendAT(Args... cmd) {
+    TINY_GSM_STAT(sent(cmd...));
     streamWrite("AT", cmd..., GSM_NL);
     stream.flush();
     TINY_GSM_YIELD();
     //DBG("### AT:", cmd...);
   }
 
-  // TODO: Optimize this!
-  uint8_t waitResponse(uint32_t timeout, String& data,
+  uint8_t waitResponse(uint32_t timeout, TinyGsmResponse& data,
                        GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
                        GsmConstStr r3=NULL, GsmConstStr r4=NULL, GsmConstStr r5=NULL)
   {
@@ -509,7 +579,7 @@ public:
     String r4s(r4); r4s.trim();
     String r5s(r5); r5s.trim();
     DBG("### ..:", r1s, ",", r2s, ",", r3s, ",", r4s, ",", r5s);*/
-    data.reserve(64);
+    matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
     int index = 0;
     unsigned long startMillis = millis();
     do {
@@ -517,68 +587,48 @@ public:
       while (stream.available() > 0) {
         int a = stream.read();
         if (a <= 0) continue; // Skip 0x00 bytes, just in case
-        data += (char)a;
-        if (r1 && data.endsWith(r1)) {
-          index = 1;
-          goto finish;
-        } else if (r2 && data.endsWith(r2)) {
-          index = 2;
-          goto finish;
-        } else if (r3 && data.endsWith(r3)) {
-          index = 3;
+        data.push((char)a);
+        uint8_t match = matcher.feed(data);
+        if (!match) {
+          continue;
+        } else if (match <= 5) {
+          index = match;
           goto finish;
-        } else if (r4 && data.endsWith(r4)) {
-          index = 4;
-          goto finish;
-        } else if (r5 && data.endsWith(r5)) {
-          index = 5;
-          goto finish;
-        } else if (data.endsWith(GF(GSM_NL "+IPD,"))) {
-          int mux = stream.readStringUntil(',').toInt();
-          int len = stream.readStringUntil(':').toInt();
-          int len_orig = len;
-          if (len > sockets[mux]->rx.free()) {
-            DBG("### Buffer overflow: ", len, "->", sockets[mux]->rx.free());
-          } else {
-            DBG("### Got: ", len, "->", sockets[mux]->rx.free());
-          }
-          while (len--) {
-            while (!stream.available()) { TINY_GSM_YIELD(); }
-            sockets[mux]->rx.put(stream.read());
-          }
-          if (len_orig > sockets[mux]->available()) { // TODO
-            DBG("### Fewer characters received than expected: ", sockets[mux]->available(), " vs ", len_orig);
-          }
-          data = "";
-        } else if (data.endsWith(GF("CLOSED"))) {
-          int muxStart = max(0,data.lastIndexOf(GSM_NL, data.length()-8));
-          int coma = data.indexOf(',', muxStart);
-          int mux = data.substring(muxStart, coma).toInt();
-          if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-            sockets[mux]->sock_connected = false;
-          }
-          data = "";
-          DBG("### Closed: ", mux);
         }
+        if (urcs.dispatch(match - 6, stream, data)) {
+          data.clear();
+        }
+        // The handler may have sent commands of its own, which loaded theirs
+        matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
       }
     } while (millis() - startMillis < timeout);
 finish:
+    TINY_GSM_STAT(received(index, index && data.endsWith(GFP(GSM_ERROR))));
     if (!index) {
       data.trim();
       if (data.length()) {
-        DBG("### Unhandled:", data);
+        DBG("### Unhandled:", data.c_str());
       }
-      data = "";
+      data.clear();
     }
     //DBG('<', index, '>');
     return index;
   }
 
+  uint8_t waitResponse(uint32_t timeout, String& data,
+                       GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
+                       GsmConstStr r3=NULL, GsmConstStr r4=NULL, GsmConstStr r5=NULL)
+  {
+    data.reserve(64);
+    TinyGsmResponse resp(data);
+    return waitResponse(timeout, resp, r1, r2, r3, r4, r5);
+  }
+
   uint8_t waitResponse(uint32_t timeout,
                        GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
                        GsmConstStr r3=NULL, GsmConstStr r4=NULL, GsmConstStr r5=NULL)
   {
-    String data;
+    TinyGsmResponse data;
     return waitResponse(timeout, data, r1, r2, r3, r4, r5);
   }
 
@@ -591,8 +641,47 @@ finish:
 public:
   Stream&       stream;
 
+#if defined(TINY_GSM_STATS)
+  // Command latencies and socket traffic, see TinyGsmStats
+  TinyGsmStats& getStats() { return stats; }
+#endif
+
 protected:
+#if defined(TINY_GSM_STATS)
+  TinyGsmStats  stats;
+#endif
   GsmClient*    sockets[TINY_GSM_MUX_COUNT];
+  TinyGsmMatcher matcher;
+  TinyGsmUrcs    urcs;
+
+  static void handleIpd(void* arg, Stream& stream, TinyGsmResponse& data) {
+    TinyGsmESP8266* modem = static_cast<TinyGsmESP8266*>(arg);
+    int mux = stream.readStringUntil(',').toInt();
+    int len = stream.readStringUntil(':').toInt();
+    int len_orig = len;
+    if (len > modem->sockets[mux]->rx.free()) {
+      DBG("### Buffer overflow: ", len, "->", modem->sockets[mux]->rx.free());
+    } else {
+      DBG("### Got: ", len, "->", modem->sockets[mux]->rx.free());
+    }
+    TinyGsmReadPayload(stream, modem->sockets[mux]->rx, len);
+#if defined(TINY_GSM_STATS)
+    modem->stats.receivedData(mux, len);
+#endif
+    if (len_orig > modem->sockets[mux]->available()) { // TODO
+      DBG("### Fewer characters received than expected: ", modem->sockets[mux]->available(), " vs ", len_orig);
+    }
+  }
+
+  static void handleClosed(void* arg, Stream& stream, TinyGsmResponse& data) {
+    TinyGsmESP8266* modem = static_cast<TinyGsmESP8266*>(arg);
+    char c = data.fromEnd(8); // "<n>,CLOSED", or just "CLOSED"
+    int mux = (c >= '0' && c <= '9') ? c - '0' : 0;
+    if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux]) {
+      modem->sockets[mux]->sock_connected = false;
+    }
+    DBG("### Closed: ", mux);
+  }
 };
 
 #endif
@@ -18,6 +18,22 @@
 
 #define TINY_GSM_MUX_COUNT 5
 
+// The driver's own URC handlers, and the matcher nodes their prefixes take
+#define TINY_GSM_URC_BUILTIN 8
+#define TINY_GSM_URC_BUILTIN_NODES 69
+
+// Bytes per socket that may be sent before the modem acknowledged them,
+// 0 (or a modem that refuses quick send mode) waits after every send
+#if !defined(TINY_GSM_SEND_WINDOW)
+#define TINY_GSM_SEND_WINDOW 2048
+#endif
+
+// A connected socket without any news for this long (ms) is probed with
+// +CIPRXGET=4 and +CIPSTATUS, in case the modem missed a URC; 0 disables
+#if !defined(TINY_GSM_SOCKET_WATCHDOG)
+#define TINY_GSM_SOCKET_WATCHDOG 10000L
+#endif
+
 #ifndef TINY_GSM_PHONEBOOK_RESULTS
 #define TINY_GSM_PHONEBOOK_RESULTS 5
 #endif
@@ -27,6 +43,14 @@
 #define GSM_NL "\r\n"
 static const char GSM_OK[] TINY_GSM_PROGMEM = "OK" GSM_NL;
 static const char GSM_ERROR[] TINY_GSM_PROGMEM = "ERROR" GSM_NL;
+static const char GSM_URC_CMTI[] TINY_GSM_PROGMEM = GSM_NL "+CMTI:";
+static const char GSM_URC_CIPRXGET[] TINY_GSM_PROGMEM = GSM_NL "+CIPRXGET:";
+static const char GSM_URC_CLOSED[] TINY_GSM_PROGMEM = "CLOSED" GSM_NL;
+static const char GSM_URC_DATA_ACCEPT[] TINY_GSM_PROGMEM = GSM_NL "DATA ACCEPT:";
+static const char GSM_URC_SEND_FAIL[] TINY_GSM_PROGMEM = "SEND FAIL" GSM_NL;
+static const char GSM_URC_CONNECT_OK[] TINY_GSM_PROGMEM = "CONNECT OK" GSM_NL;
+static const char GSM_URC_CONNECT_FAIL[] TINY_GSM_PROGMEM = "CONNECT FAIL" GSM_NL;
+static const char GSM_URC_CLOSE_OK[] TINY_GSM_PROGMEM = "CLOSE OK" GSM_NL;
 
 // New SMS Callback
 #if defined(ESP8266) || defined(ESP32)
@@ -141,8 +165,10 @@ public:
       this->at = modem;
       this->mux = mux;
       sock_available = 0;
+      sock_unacked = 0;
       prev_check = 0;
       sock_connected = false;
+      sock_opening = false;
       got_data = false;
 
       at->sockets[mux] = this;
@@ -156,38 +182,93 @@ public:
       stop();
       TINY_GSM_YIELD();
       rx.clear();
+      clearWriteError();
+      sock_unacked = 0;
       sock_connected = at->modemConnect(host, port, mux);
+      prev_check = millis();
       return sock_connected;
     }
 
     virtual int connect(IPAddress ip, uint16_t port)
     {
-      String host;
-      host.reserve(16);
-      host += ip[0];
-      host += ".";
-      host += ip[1];
-      host += ".";
-      host += ip[2];
-      host += ".";
-      host += ip[3];
-      return connect(host.c_str(), port);
+      return connect(TinyGsmIpToString(ip).c_str(), port);
+    }
+
+    // Starts connecting and returns at once, pollConnect() until it is
+    // no longer PENDING. host must stay valid until then. While the socket
+    // opens nothing is in flight, the other sockets keep working
+    virtual bool connectAsync(const char *host, uint16_t port)
+    {
+      if (sock_connected)
+      {
+        stop();
+      }
+      rx.clear();
+      clearWriteError();
+      sock_unacked = 0;
+      return at->beginConnect(host, port, mux);
+    }
+
+    AsyncStatus pollConnect()
+    {
+      return at->pollConnect(mux);
+    }
+
+    // Sends the open and returns once the modem took it, the outcome comes
+    // later as a URC. Start several clients this way, then wait for them all
+    // with waitConnections(), so their handshakes overlap.
+    // Don't mix with connectAsync() while opens are pending
+    virtual bool connectStart(const char *host, uint16_t port)
+    {
+      if (sock_connected)
+      {
+        stop();
+      }
+      rx.clear();
+      clearWriteError();
+      sock_unacked = 0;
+      return at->modemConnectStart(host, port, mux);
+    }
+
+    // True while the outcome of connectStart() is not known yet
+    bool connecting()
+    {
+      return sock_opening;
     }
 
     virtual void stop()
     {
       TINY_GSM_YIELD();
+      flushTx();
       at->sendAT(GF("+CIPCLOSE="), mux);
       sock_connected = false;
-      at->waitResponse();
+      at->waitResponse(GFP(GSM_OK), GFP(GSM_ERROR), GFP(GSM_URC_CLOSE_OK));
       rx.clear();
       sock_available = 0;
+      sock_unacked = 0;
     }
 
     virtual size_t write(const uint8_t *buf, size_t size)
     {
       TINY_GSM_YIELD();
-      at->maintain();
+      if (!sock_connected || getWriteError())
+      {
+        return 0;
+      }
+      if (tx.append(buf, size))
+      {
+        return size;
+      }
+      if (!flushTx())
+      {
+        return 0;
+      }
+      if (tx.append(buf, size))
+      {
+        return size;
+      }
+      // No maintain() here: modemSend() handles the URCs that are queued up,
+      // maintain() would idle on the acknowledgements of earlier sends
       return at->modemSend(buf, size, mux);
     }
 
@@ -206,16 +287,10 @@ public:
     virtual int available()
     {
       TINY_GSM_YIELD();
+      flushTx();
       if (!rx.size() && sock_connected)
       {
-        // Workaround: sometimes SIM800 forgets to notify about data arrival.
-        // TODO: Currently we ping the module periodically,
-        // but maybe there's a better indicator that we need to poll
-        if (millis() - prev_check > 500)
-        {
-          got_data = true;
-          prev_check = millis();
-        }
+        // New data is announced by +CIPRXGET: 1, see maintain()
         at->maintain();
       }
       return rx.size() + sock_available;
@@ -224,6 +299,7 @@ public:
     virtual int read(uint8_t *buf, size_t size)
     {
       TINY_GSM_YIELD();
+      flushTx();
       at->maintain();
       size_t cnt = 0;
       while (cnt < size && sock_connected)
@@ -236,15 +312,22 @@ public:
           cnt += chunk;
           continue;
         }
-        // TODO: Read directly into user buffer?
         at->maintain();
-        if (sock_available > 0)
+        if (sock_available == 0)
         {
-          at->modemRead(rx.free(), mux);
+          break;
+        }
+        // Large reads go straight into the caller's buffer,
+        // the fifo only keeps what a small read leaves over
+        if (size - cnt >= (size_t)rx.free())
+        {
+          size_t len = TinyGsmMin(at->modemRead(size - cnt, mux, buf), size - cnt);
+          buf += len;
+          cnt += len;
         }
         else
         {
-          break;
+          at->modemRead(rx.free(), mux);
         }
       }
       return cnt;
@@ -260,8 +343,35 @@ public:
       return -1;
     }
 
-    virtual int peek() { return -1; } //TODO
-    virtual void flush() { at->stream.flush(); }
+    virtual int peek()
+    {
+      flushTx();
+      if (!rx.size())
+      {
+        at->maintain();
+        // Refill the fifo, the modem reports what is left in sock_available
+        if (sock_available > 0)
+        {
+          at->modemRead(rx.free(), mux);
+        }
+      }
+      const uint8_t *p;
+      if (rx.peek(p) > 0)
+      {
+        return *p;
+      }
+      return -1;
+    }
+
+    virtual void flush()
+    {
+      flushTx();
+#if TINY_GSM_SEND_WINDOW > 0
+      // Wait until the modem acknowledged everything in flight
+      at->modemSendWindow(mux, TINY_GSM_SEND_WINDOW);
+#endif
+      at->stream.flush();
+    }
 
     virtual uint8_t connected()
     {
@@ -280,13 +390,32 @@ public:
     String remoteIP() TINY_GSM_ATTR_NOT_IMPLEMENTED;
 
   private:
+    // Sends what write() collected, see TinyGsmTxBuffer
+    bool flushTx()
+    {
+      if (!tx.size())
+      {
+        return true;
+      }
+      bool ok = sock_connected && (size_t)at->modemSend(tx.data(), tx.size(), mux) == tx.size();
+      tx.clear();
+      if (!ok)
+      {
+        setWriteError();
+      }
+      return ok;
+    }
+
     TinyGsmSim800 *at;
     uint8_t mux;
     uint16_t sock_available;
+    uint16_t sock_unacked;
     uint32_t prev_check;
     bool sock_connected;
+    bool sock_opening;
     bool got_data;
     RxFifo rx;
+    TinyGsmTxBuffer tx;
   };
 
   class GsmClientSecure : public GsmClient
@@ -305,21 +434,243 @@ public:
       stop();
       TINY_GSM_YIELD();
       rx.clear();
+      clearWriteError();
+      sock_unacked = 0;
       sock_connected = at->modemConnect(host, port, mux, true);
+      prev_check = millis();
+      return sock_connected;
+    }
+
+    virtual bool connectAsync(const char *host, uint16_t port)
+    {
+      if (sock_connected)
+      {
+        stop();
+      }
+      rx.clear();
+      clearWriteError();
+      sock_unacked = 0;
+      return at->beginConnect(host, port, mux, true);
+    }
+
+    virtual bool connectStart(const char *host, uint16_t port)
+    {
+      if (sock_connected)
+      {
+        stop();
+      }
+      rx.clear();
+      clearWriteError();
+      sock_unacked = 0;
+      return at->modemConnectStart(host, port, mux, true);
+    }
+  };
+
+  /*
+   * Client for transparent mode (see setTransparentMode()).
+   * While connected, the UART is a raw pipe to the single socket. Modem
+   * functions that need AT commands leave data mode with the +++ escape,
+   * and the next read or write returns to it with ATO; available() and
+   * peek() only report what is already there.
+   * A remote close shows up in the data as "CLOSED"; connected() only
+   * notices it when the modem refuses to return to data mode.
+   */
+  class GsmClientTransparent : public Client
+  {
+    friend class TinyGsmSim800;
+    typedef TinyGsmFifo<uint8_t, TINY_GSM_RX_BUFFER> RxFifo;
+
+  public:
+    GsmClientTransparent() {}
+
+    GsmClientTransparent(TinyGsmSim800 &modem)
+    {
+      init(&modem);
+    }
+
+    bool init(TinyGsmSim800 *modem)
+    {
+      this->at = modem;
+      sock_connected = false;
+
+      at->transparent_sock = this;
+
+      return true;
+    }
+
+  public:
+    virtual int connect(const char *host, uint16_t port)
+    {
+      stop();
+      TINY_GSM_YIELD();
+      rx.clear();
+      sock_connected = at->modemConnectTransparent(host, port);
+      return sock_connected;
+    }
+
+    virtual int connect(IPAddress ip, uint16_t port)
+    {
+      return connect(TinyGsmIpToString(ip).c_str(), port);
+    }
+
+    virtual void stop()
+    {
+      TINY_GSM_YIELD();
+      if (sock_connected)
+      {
+        at->sendAT(GF("+CIPCLOSE"));
+        at->waitResponse(GF("CLOSE OK" GSM_NL));
+      }
+      sock_connected = false;
+      rx.clear();
+    }
+
+    virtual size_t write(const uint8_t *buf, size_t size)
+    {
+      if (!at->resumeDataMode())
+      {
+        return 0;
+      }
+      size_t n = at->stream.write(buf, size);
+      at->data_last = millis();
+      return n;
+    }
+
+    virtual size_t write(uint8_t c)
+    {
+      return write(&c, 1);
+    }
+
+    virtual size_t write(const char *str)
+    {
+      if (str == NULL)
+        return 0;
+      return write((const uint8_t *)str, strlen(str));
+    }
+
+    virtual int available()
+    {
+      TINY_GSM_YIELD();
+      if (!at->data_mode)
+      {
+        return rx.size();
+      }
+      return rx.size() + at->stream.available();
+    }
+
+    virtual int read(uint8_t *buf, size_t size)
+    {
+      TINY_GSM_YIELD();
+      // What arrived while the modem was in command mode comes first
+      size_t cnt = rx.get(buf, size);
+      if (cnt < size && at->resumeDataMode())
+      {
+        size_t len = TinyGsmMin(size - cnt, (size_t)at->stream.available());
+        cnt += at->stream.readBytes((char *)buf + cnt, len);
+      }
+      return cnt;
+    }
+
+    virtual int read()
+    {
+      uint8_t c;
+      if (read(&c, 1) == 1)
+      {
+        return c;
+      }
+      return -1;
+    }
+
+    virtual int peek()
+    {
+      const uint8_t *p;
+      if (rx.peek(p) > 0)
+      {
+        return *p;
+      }
+      if (!at->data_mode)
+      {
+        return -1;
+      }
+      return at->stream.peek();
+    }
+
+    virtual void flush() { at->stream.flush(); }
+
+    virtual uint8_t connected()
+    {
+      if (available())
+      {
+        return true;
+      }
       return sock_connected;
     }
+    virtual operator bool() { return connected(); }
+
+    /*
+   * Extended API
+   */
+
+    String remoteIP() TINY_GSM_ATTR_NOT_IMPLEMENTED;
+
+  private:
+    TinyGsmSim800 *at;
+    bool sock_connected;
+    RxFifo rx;
   };
 #endif // TINY_GSM_NO_GPRS
 
 public:
   TinyGsmSim800(Stream &stream)
-      : stream(stream)
-  {
+      : stream(stream), async_data(async_buf, sizeof(async_buf))
+  {
+    async_status = AsyncStatus::IDLE;
+    async_running = false;
+    async_queued = false;
+    async_pause = false;
+    async_polling = false;
+    async_op = ASYNC_NETWORK;
 #ifndef TINY_GSM_NO_GPRS
     memset(sockets, 0, sizeof(sockets));
+    transparent_sock = NULL;
+    transparent = false;
+    quick_send = true;
+    data_mode = false;
+    data_last = 0;
 #endif // TINY_GSM_NO_GPRS
 
 setNewSMSCallback(NULL);
+    urcs.add(GFP(GSM_URC_CMTI), handleCmti, this);
+#ifndef TINY_GSM_NO_GPRS
+    urcs.add(GFP(GSM_URC_CIPRXGET), handleCipRxGet, this);
+    urcs.add(GFP(GSM_URC_CLOSED), handleClosed, this);
+    urcs.add(GFP(GSM_URC_DATA_ACCEPT), handleDataAccept, this);
+    urcs.add(GFP(GSM_URC_SEND_FAIL), handleSendFail, this);
+    urcs.add(GFP(GSM_URC_CONNECT_OK), handleConnect, this);
+    urcs.add(GFP(GSM_URC_CONNECT_FAIL), handleConnect, this);
+    urcs.add(GFP(GSM_URC_CLOSE_OK), handleConnect, this);
+#endif // TINY_GSM_NO_GPRS
+  }
+
+  /*
+   * Unsolicited result codes
+   */
+
+  // The handler runs whenever a line starting with prefix arrives
+  // while the library waits for a response, e.g. in maintain()
+  bool addUrcHandler(GsmConstStr prefix, TinyGsmUrcHandler handler, void *arg = NULL)
+  {
+    return urcs.add(prefix, handler, arg);
+  }
+
+  bool addUrcHandlers(const TinyGsmUrc *table, uint8_t count)
+  {
+    return urcs.add(table, count);
+  }
+
+  bool removeUrcHandler(GsmConstStr prefix)
+  {
+    return urcs.remove(prefix);
   }
   
   /*
@@ -416,21 +767,52 @@ setNewSMSCallback(NULL);
 
   void maintain()
   {
+    if (async_running || async_status == AsyncStatus::PENDING || !commands.empty())
+    {
+      pollAsync();
+      // The sockets get their turn between the commands
+      if (async_running)
+      {
+        return;
+      }
+    }
 #ifndef TINY_GSM_NO_GPRS
+    // In data mode the stream carries payload only
+    if (data_mode)
+    {
+      return;
+    }
+    // URCs first, so got_data is up to date
+    while (stream.available())
+    {
+      waitResponse(10, NULL, NULL);
+    }
+    bool probe = false;
     for (int mux = 0; mux < TINY_GSM_MUX_COUNT; mux++)
     {
       GsmClient *sock = sockets[mux];
+      if (sock && sock->tx.idle())
+      {
+        sock->flushTx();
+      }
       if (sock && sock->got_data)
       {
         sock->got_data = false;
         sock->sock_available = modemGetAvailable(mux);
       }
+#if TINY_GSM_SOCKET_WATCHDOG > 0
+      else if (sock && sock->sock_connected &&
+               millis() - sock->prev_check > TINY_GSM_SOCKET_WATCHDOG)
+      {
+        probe = true;
+      }
+#endif
     }
-#endif // TINY_GSM_NO_GPRS
-    while (stream.available())
+    if (probe)
     {
-      waitResponse(10, NULL, NULL);
+      modemProbe();
     }
+#endif // TINY_GSM_NO_GPRS
   }
 
   bool factoryDefault()
@@ -728,30 +1110,47 @@ setNewSMSCallback(NULL);
 
     // TODO: wait AT+CGATT?
 
-    // Set to multi-IP
-    sendAT(GF("+CIPMUX=1"));
-    if (waitResponse() != 1)
+    if (transparent)
     {
-      return false;
-    }
+      // Single connection, as a raw pipe
+      sendAT(GF("+CIPMUX=0"));
+      if (waitResponse() != 1)
+      {
+        return false;
+      }
 
-    // Put in "quick send" mode (thus no extra "Send OK")
-    sendAT(GF("+CIPQSEND=1"));
-    if (waitResponse() != 1)
-    {
-      return false;
+      sendAT(GF("+CIPMODE=1"));
+      if (waitResponse() != 1)
+      {
+        return false;
+      }
     }
-
-    // Set to get data manually
-    sendAT(GF("+CIPRXGET=1"));
-    if (waitResponse() != 1)
+    else
     {
-      return false;
-    }
+      // Set to multi-IP
+      sendAT(GF("+CIPMUX=1"));
+      if (waitResponse() != 1)
+      {
+        return false;
+      }
 
-    // Start Task and Set APN, USER NAME, PASSWORD
-    sendAT(GF("+CSTT=\""), apn, GF("\",\""), user, GF("\",\""), pwd, GF("\""));
-    if (waitResponse(60000L) != 1)
+      sendAT(GF("+CIPMODE=0"));
+      waitResponse();
+
+      // Put in "quick send" mode (thus no extra "Send OK")
+      quick_send = modemQuickSend();
+
+      // Set to get data manually
+      sendAT(GF("+CIPRXGET=1"));
+      if (waitResponse() != 1)
+      {
+        return false;
+      }
+    }
+
+    // Start Task and Set APN, USER NAME, PASSWORD
+    sendAT(GF("+CSTT=\""), apn, GF("\",\""), user, GF("\",\""), pwd, GF("\""));
+    if (waitResponse(60000L) != 1)
     {
       return false;
     }
@@ -793,6 +1192,167 @@ setNewSMSCallback(NULL);
 
     return true;
   }
+  /*
+   * Transparent mode
+   */
+
+  // Switches GPRS to a single socket in transparent mode (AT+CIPMODE=1),
+  // used through GsmClientTransparent; takes effect on the next gprsConnect()
+  void setTransparentMode(bool enable)
+  {
+    transparent = enable;
+  }
+
+  // Leaves data mode with the +++ escape sequence, so AT commands can run.
+  // sendAT() does this on its own, it only has to be called to stop the
+  // modem from forwarding data
+  bool escapeDataMode()
+  {
+    if (!data_mode)
+    {
+      return true;
+    }
+    // Nothing may be sent for 1 s before +++, anything received meanwhile
+    // is kept for the client
+    while (millis() - data_last < 1000)
+    {
+      escapeDrain();
+      TINY_GSM_YIELD();
+    }
+    escapeDrain();
+    stream.print(GF("+++"));
+    stream.flush();
+    data_mode = false;
+    // The modem answers after another 0.5 s of silence
+    return escapeWaitOk(2000L);
+  }
+
+  // Returns to data mode with ATO, after escapeDataMode()
+  bool resumeDataMode()
+  {
+    if (data_mode)
+    {
+      return true;
+    }
+    if (!transparent_sock || !transparent_sock->sock_connected)
+    {
+      return false;
+    }
+    sendAT(GF("O"));
+    if (waitResponse(5000L, GF(GSM_NL "CONNECT" GSM_NL), GFP(GSM_ERROR),
+                     GF("NO CARRIER" GSM_NL)) != 1)
+    {
+      transparent_sock->sock_connected = false;
+      return false;
+    }
+    data_mode = true;
+    data_last = millis();
+    return true;
+  }
+
+  /*
+   * Non-blocking operations
+   * begin*() sends the first command and returns at once, poll*() parses
+   * what the modem sent so far and returns PENDING until the operation is
+   * DONE or FAILED. One operation runs at a time; maintain() keeps it going
+   * as well, and serves the sockets between its commands.
+   * A blocking call waits until the command in flight is answered. From a
+   * URC handler that runs meanwhile it is rejected (fails) instead.
+   * Strings passed to begin*() must stay valid until the operation is over.
+   */
+  bool beginWaitForNetwork(unsigned long timeout = 60000L)
+  {
+    return asyncBegin(ASYNC_NETWORK, timeout);
+  }
+
+  AsyncStatus pollWaitForNetwork()
+  {
+    return pollAsync();
+  }
+
+#ifndef TINY_GSM_NO_GPRS
+  bool beginGprsConnect(const char *apn, const char *user = NULL, const char *pwd = NULL)
+  {
+    if (async_status == AsyncStatus::PENDING)
+    {
+      return false;
+    }
+    async_apn = apn;
+    async_user = user;
+    async_pwd = pwd;
+    return asyncBegin(ASYNC_GPRS, 0);
+  }
+
+  AsyncStatus pollGprsConnect()
+  {
+    return pollAsync();
+  }
+#endif // TINY_GSM_NO_GPRS
+
+  /*
+   * Command queue
+   * queueAT() stores a command (without the "AT") and returns at once.
+   * Queued commands are sent one after another from maintain(), higher
+   * priority first, and the callback gets the terminator that matched.
+   * A pending begin*() operation goes ahead of the queue.
+   */
+  bool queueAT(const char *cmd, TinyGsmCommandCallback callback, void *arg = NULL,
+               uint8_t priority = 0, uint32_t timeout = 1000L,
+               GsmConstStr r1 = GFP(GSM_OK), GsmConstStr r2 = GFP(GSM_ERROR),
+               GsmConstStr r3 = NULL)
+  {
+    if (strlen(cmd) >= TINY_GSM_COMMAND_LENGTH)
+    {
+      return false;
+    }
+    TinyGsmCommand *c = commands.insert(priority);
+    if (!c)
+    {
+      return false;
+    }
+    strcpy(c->cmd, cmd);
+    c->r1 = r1;
+    c->r2 = r2;
+    c->r3 = r3;
+    c->timeout = timeout;
+    c->callback = callback;
+    c->arg = arg;
+    return true;
+  }
+
+  // Number of queued commands, including the one in flight
+  uint8_t queuedAT()
+  {
+    return commands.size();
+  }
+
+  // Advances the running operation and the command queue, parsing at most
+  // TINY_GSM_ASYNC_SLICE bytes. Returns the state of the begin*() operation
+  AsyncStatus pollAsync()
+  {
+    // Called again from a URC handler or command callback
+    if (async_polling)
+    {
+      return async_status;
+    }
+    async_polling = true;
+    asyncPoll();
+    async_polling = false;
+    return async_status;
+  }
+
+  // Abandons the begin*() operation, its last command may still answer
+  void cancelAsync()
+  {
+    if (async_status == AsyncStatus::PENDING)
+    {
+      async_status = AsyncStatus::IDLE;
+      if (!async_queued)
+      {
+        async_running = false;
+      }
+    }
+  }
 
   bool isGprsConnected()
   {
@@ -831,6 +1391,49 @@ setNewSMSCallback(NULL);
   {
     return TinyGsmIpFromString(getLocalIP());
   }
+
+  // Looks the address of host up with AT+CDNSGIP. connect() uses it
+  // instead of the name until TINY_GSM_DNS_TTL has passed
+  bool resolve(const char *host, IPAddress &ip)
+  {
+    if (dns.lookup(host, ip))
+    {
+      return true;
+    }
+    sendAT(GF("+CDNSGIP=\""), host, '"');
+    if (waitResponse() != 1)
+    {
+      return false;
+    }
+    // +CDNSGIP: 1,"<host>","<ip>"[,"<ip2>"] or +CDNSGIP: 0,<error>
+    if (waitResponse(30000L, GF("+CDNSGIP:")) != 1)
+    {
+      return false;
+    }
+    if (stream.readStringUntil(',').toInt() != 1)
+    {
+      streamSkipUntil('\n');
+      return false;
+    }
+    streamSkipUntil(','); // Skip the host name
+    streamSkipUntil('"');
+    ip = TinyGsmIpFromString(stream.readStringUntil('"'));
+    streamSkipUntil('\n');
+    dns.store(host, ip);
+    return ip[0] != 0;
+  }
+
+  void clearDnsCache()
+  {
+    dns.clear();
+  }
+
+  // Waits until the clients started with GsmClient::connectStart() know
+  // their outcome. Returns true if all of them connected
+  bool waitConnections(uint32_t timeout = 75000L)
+  {
+    return modemWaitConnections(-1, timeout);
+  }
 #endif // TINY_GSM_NO_GPRS
   /*
    * Phone Call functions
@@ -1249,8 +1852,7 @@ setNewSMSCallback(NULL);
       //   break;
       // }
       sms.message = data;
-      DEBUG_PORT.print("SMS message is ");
-      DEBUG_PORT.println(sms.message);
+      DBG("SMS message is", sms.message);
       sms_array[ind] = sms;
       ind++;
       if (limit && ind >= limit)
@@ -1621,6 +2223,23 @@ protected:
 #ifndef TINY_GSM_NO_GPRS
   bool modemConnect(const char *host, uint16_t port, uint8_t mux, bool ssl = false)
   {
+    bool cached = false;
+    bool ok = modemConnectStart(host, port, mux, ssl, &cached) &&
+              modemWaitConnections(mux, 75000L);
+    if (cached && !ok)
+    {
+      dns.remove(host); // The host may have moved, look it up again next time
+    }
+    return ok;
+  }
+
+  // Sends CIPSTART and returns once the modem accepted it,
+  // handleConnect() takes the outcome. Sets *cached if it dialled an
+  // address from the DNS cache
+  bool modemConnectStart(const char *host, uint16_t port, uint8_t mux, bool ssl = false,
+                         bool *cached = NULL)
+  {
+    GsmClient *sock = sockets[mux];
     int rsp;
 #if !defined(TINY_GSM_MODEM_SIM900)
     sendAT(GF("+CIPSSL="), ssl);
@@ -1630,19 +2249,172 @@ protected:
       return false;
     }
 #endif
-    sendAT(GF("+CIPSTART="), mux, ',', GF("\"TCP"), GF("\",\""), host, GF("\","), port);
-    rsp = waitResponse(75000L,
-                       GF("CONNECT OK" GSM_NL),
-                       GF("CONNECT FAIL" GSM_NL),
-                       GF("ALREADY CONNECT" GSM_NL),
-                       GF("ERROR" GSM_NL),
-                       GF("CLOSE OK" GSM_NL) // Happens when HTTPS handshake fails
-    );
-    return (1 == rsp);
+    // SSL connects go by name, the modem sends it for SNI
+    IPAddress ip;
+    if (!ssl && dns.lookup(host, ip))
+    {
+      if (cached)
+      {
+        *cached = true;
+      }
+      sendAT(GF("+CIPSTART="), mux, ',', GF("\"TCP"), GF("\",\""), TinyGsmIpToString(ip), GF("\","), port);
+    }
+    else
+    {
+      sendAT(GF("+CIPSTART="), mux, ',', GF("\"TCP"), GF("\",\""), host, GF("\","), port);
+    }
+    rsp = waitResponse();
+    sock->sock_connected = false;
+    sock->sock_opening = (1 == rsp);
+    sock->prev_check = millis();
+    return sock->sock_opening;
+  }
+
+  // Takes URCs until the connect of socket mux, or of all sockets if mux
+  // is negative, has an outcome. Those still pending after timeout are closed.
+  // Returns true if all of them connected
+  bool modemWaitConnections(int mux, uint32_t timeout)
+  {
+    uint32_t start = millis();
+    bool ok;
+    for (;;)
+    {
+      bool pending = false;
+      ok = true;
+      for (int i = 0; i < TINY_GSM_MUX_COUNT; i++)
+      {
+        GsmClient *sock = sockets[i];
+        if (!sock || (mux >= 0 && i != mux))
+        {
+          continue;
+        }
+        if (sock->sock_opening && millis() - start >= timeout)
+        {
+          sock->stop();
+          sock->sock_opening = false;
+        }
+        pending |= sock->sock_opening;
+        ok &= sock->sock_opening || sock->sock_connected;
+      }
+      if (!pending)
+      {
+        return ok;
+      }
+      TinyGsmResponse data;
+      uint32_t spent = millis() - start;
+      if (waitResponse(spent < timeout ? timeout - spent : 0, data,
+                       GFP(GSM_URC_CONNECT_OK),
+                       GFP(GSM_URC_CONNECT_FAIL),
+                       GFP(GSM_URC_CLOSE_OK)))
+      {
+        handleConnect(this, stream, data);
+      }
+    }
+  }
+
+  bool modemConnectTransparent(const char *host, uint16_t port)
+  {
+    sendAT(GF("+CIPSTART="), GF("\"TCP"), GF("\",\""), host, GF("\","), port);
+    int rsp = waitResponse(75000L,
+                           GF(GSM_NL "CONNECT" GSM_NL),
+                           GF("CONNECT FAIL" GSM_NL),
+                           GF("ALREADY CONNECT" GSM_NL),
+                           GF("ERROR" GSM_NL));
+    if (rsp != 1)
+    {
+      return false;
+    }
+    data_mode = true;
+    data_last = millis();
+    return true;
+  }
+
+  // Keeps what arrives before the +++ escape
+  void escapeDrain()
+  {
+    int len = stream.available();
+    if (len > 0 && transparent_sock)
+    {
+      TinyGsmReadPayload(stream, transparent_sock->rx, len);
+    }
+  }
+
+  void escapeKeep(const char *p, uint8_t len)
+  {
+    while (len--)
+    {
+      if (!transparent_sock || !transparent_sock->rx.put((uint8_t)*p++))
+      {
+        DBG("### Escape, payload dropped");
+        return;
+      }
+    }
+  }
+
+  // Waits for the answer to +++. The modem may still forward payload until
+  // it takes the escape, that goes to the client instead of being dropped
+  bool escapeWaitOk(uint32_t timeout)
+  {
+    static const char ok[] = GSM_NL "OK" GSM_NL;
+    uint8_t matched = 0;
+    uint32_t start = millis();
+    while (millis() - start < timeout)
+    {
+      if (stream.available() <= 0)
+      {
+        TINY_GSM_YIELD();
+        continue;
+      }
+      char c = stream.read();
+      while (matched && c != ok[matched])
+      {
+        // Only "\r" can start the answer over, after "\r\nOK\r"
+        uint8_t keep = (matched == 5) ? 1 : 0;
+        escapeKeep(ok, matched - keep);
+        matched = keep;
+      }
+      if (c != ok[matched])
+      {
+        escapeKeep(&c, 1);
+      }
+      else if (++matched == sizeof(ok) - 1)
+      {
+        return true;
+      }
+    }
+    escapeKeep(ok, matched);
+    return false;
+  }
+
+
+  // Turns on quick send mode, and asks whether the modem really took it;
+  // without it sends are confirmed by "SEND OK" instead of DATA ACCEPT
+  bool modemQuickSend()
+  {
+    sendAT(GF("+CIPQSEND=1"));
+    waitResponse();
+    sendAT(GF("+CIPQSEND?"));
+    if (waitResponse(GF("+CIPQSEND:")) != 1)
+    {
+      return false;
+    }
+    bool on = stream.readStringUntil('\n').toInt() == 1;
+    waitResponse();
+    if (!on)
+    {
+      DBG("### No quick send, waiting for every send");
+    }
+    return on;
   }
 
   int modemSend(const void *buff, size_t len, uint8_t mux)
   {
+#if TINY_GSM_SEND_WINDOW > 0
+    if (quick_send && !modemSendWindow(mux, len))
+    {
+      return 0;
+    }
+#endif
     sendAT(GF("+CIPSEND="), mux, ',', len);
     if (waitResponse(GF(">")) != 1)
     {
@@ -1650,25 +2422,75 @@ protected:
     }
     stream.write((uint8_t *)buff, len);
     stream.flush();
-    if (waitResponse(GF(GSM_NL "DATA ACCEPT:")) != 1)
+    TINY_GSM_STAT(sentData(mux, len));
+#if TINY_GSM_SEND_WINDOW > 0
+    if (quick_send)
+    {
+      // The DATA ACCEPT comes later as a URC, a SEND FAIL sets the write error
+      sockets[mux]->sock_unacked += len;
+      return len;
+    }
+#endif
+    switch (waitResponse(GF(GSM_NL "DATA ACCEPT:"), GF("SEND OK" GSM_NL),
+                         GFP(GSM_URC_SEND_FAIL), GFP(GSM_ERROR)))
     {
+    case 1:
+      streamSkipUntil(','); // Skip mux
+      return stream.readStringUntil('\n').toInt();
+    case 2:
+      return len;
+    default:
+      DBG("### Send failed:", mux);
       return 0;
     }
-    streamSkipUntil(','); // Skip mux
-    return stream.readStringUntil('\n').toInt();
   }
 
-  size_t modemRead(size_t size, uint8_t mux)
+  // Waits until len more bytes fit into the send window of the socket.
+  // A single send larger than the window waits until nothing is in flight
+  bool modemSendWindow(uint8_t mux, size_t len, uint32_t timeout = 10000L)
+  {
+    GsmClient *sock = sockets[mux];
+    uint32_t start = millis();
+    while (sock->sock_unacked && sock->sock_unacked + len > TINY_GSM_SEND_WINDOW)
+    {
+      uint32_t elapsed = millis() - start;
+      if (elapsed >= timeout ||
+          waitResponse(timeout - elapsed, GFP(GSM_URC_DATA_ACCEPT)) != 1)
+      {
+        DBG("### Unacknowledged:", mux, sock->sock_unacked);
+        return false;
+      }
+      modemDataAccept();
+    }
+    return true;
+  }
+
+  // Parses "<mux>,<len>" after DATA ACCEPT:
+  void modemDataAccept()
+  {
+    int mux = stream.readStringUntil(',').toInt();
+    uint16_t len = stream.readStringUntil('\n').toInt();
+    if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux])
+    {
+      GsmClient *sock = sockets[mux];
+      sock->sock_unacked -= TinyGsmMin(len, sock->sock_unacked);
+    }
+  }
+
+  // Reads up to size bytes into buf, or into the socket fifo if buf is NULL
+  size_t modemRead(size_t size, uint8_t mux, uint8_t *buf = NULL)
   {
 #ifdef TINY_GSM_USE_HEX
+    size = TinyGsmMin(size, (size_t)730);
     sendAT(GF("+CIPRXGET=3,"), mux, ',', size);
-    if (waitResponse(GF("+CIPRXGET:")) != 1)
+    if (waitResponse(GF(GSM_NL "+CIPRXGET:")) != 1)
     {
       return 0;
     }
 #else
+    size = TinyGsmMin(size, (size_t)1460);
     sendAT(GF("+CIPRXGET=2,"), mux, ',', size);
-    if (waitResponse(GF("+CIPRXGET:")) != 1)
+    if (waitResponse(GF(GSM_NL "+CIPRXGET:")) != 1)
     {
       return 0;
     }
@@ -1677,29 +2499,14 @@ protected:
     streamSkipUntil(','); // Skip mux
     size_t len = stream.readStringUntil(',').toInt();
     sockets[mux]->sock_available = stream.readStringUntil('\n').toInt();
+    sockets[mux]->prev_check = millis();
 
-    for (size_t i = 0; i < len; i++)
-    {
 #ifdef TINY_GSM_USE_HEX
-      while (stream.available() < 2)
-      {
-        TINY_GSM_YIELD();
-      }
-      char buf[4] = {
-          0,
-      };
-      buf[0] = stream.read();
-      buf[1] = stream.read();
-      char c = strtol(buf, NULL, 16);
+    len = TinyGsmReadPayload(stream, sockets[mux]->rx, len, buf, size, true);
 #else
-      while (!stream.available())
-      {
-        TINY_GSM_YIELD();
-      }
-      char c = stream.read();
+    len = TinyGsmReadPayload(stream, sockets[mux]->rx, len, buf, size);
 #endif
-      sockets[mux]->rx.put(c);
-    }
+    TINY_GSM_STAT(receivedData(mux, len));
     waitResponse();
     return len;
   }
@@ -1708,49 +2515,557 @@ protected:
   {
     sendAT(GF("+CIPRXGET=4,"), mux);
     size_t result = 0;
-    if (waitResponse(GF("+CIPRXGET:")) == 1)
+    if (waitResponse(GF(GSM_NL "+CIPRXGET:")) == 1)
     {
       streamSkipUntil(','); // Skip mode 4
       streamSkipUntil(','); // Skip mux
       result = stream.readStringUntil('\n').toInt();
       waitResponse();
     }
-    // Due to a bug in SIM800, Sometimes result is positive, but its actually not connected. 
-    
-    /* if (!result)
-    {
-      sockets[mux]->sock_connected = modemGetConnected(mux);
-    } */
-    // So we'll change this block so as to always check for sock_connected. 
-    sockets[mux]->sock_connected = modemGetConnected(mux);
-
-
+    sockets[mux]->prev_check = millis();
     return result;
   }
 
-  bool modemGetConnected(uint8_t mux)
-  {
-    sendAT(GF("+CIPSTATUS="), mux);
-    int res = waitResponse(GF(",\"CONNECTED\""), GF(",\"CLOSED\""), GF(",\"CLOSING\""), GF(",\"REMOTE CLOSING\""), GF(",\"INITIAL\""));
-    waitResponse();
-    return 1 == res;
-  }
-#endif // TINY_GSM_NO_GPRS
-public:
-  /* Utilities */
-
-  template <typename T>
-  void streamWrite(T last)
+  // Watchdog check of quiet sockets, as sometimes SIM800 forgets to notify
+  // about data arrival or closing. One +CIPSTATUS covers all of them
+  void modemProbe()
   {
-    stream.print(last);
+    modemGetConnections();
+    for (int mux = 0; mux < TINY_GSM_MUX_COUNT; mux++)
+    {
+      GsmClient *sock = sockets[mux];
+      if (sock && sock->sock_connected &&
+          millis() - sock->prev_check > TINY_GSM_SOCKET_WATCHDOG)
+      {
+        sock->sock_available = modemGetAvailable(mux);
+      }
+    }
   }
 
-  template <typename T, typename... Args>
-  void streamWrite(T head, Args... tail)
+  // Updates sock_connected of all sockets from a single AT+CIPSTATUS:
+  //   OK
+  //   STATE: IP PROCESSING
+  //   C: 0,0,"TCP","1.2.3.4","80","CONNECTED"
+  //   C: 1,,"","","","INITIAL"
+  //   ...
+  bool modemGetConnections()
   {
-    stream.print(head);
-    streamWrite(tail...);
-  }
+#if defined(TINY_GSM_MODEM_SIM900)
+    const int last = 7; // Connections listed
+#else
+    const int last = 5;
+#endif
+    sendAT(GF("+CIPSTATUS"));
+    if (waitResponse() != 1)
+    {
+      return false;
+    }
+    for (int n = 0; n <= last; n++)
+    {
+      if (waitResponse(1000L, GF("C: ")) != 1)
+      {
+        return false;
+      }
+      int mux = stream.readStringUntil(',').toInt();
+      String line = stream.readStringUntil('\n');
+      if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux])
+      {
+        // Due to a bug in SIM800, sometimes +CIPRXGET=4 reports data
+        // although the socket is not connected, this is what counts
+        sockets[mux]->sock_connected = line.indexOf(GF("\"CONNECTED\"")) >= 0;
+      }
+      if (mux >= last)
+      {
+        break;
+      }
+    }
+    return true;
+  }
+
+  bool modemGetConnected(uint8_t mux)
+  {
+    sendAT(GF("+CIPSTATUS="), mux);
+    int res = waitResponse(GF(",\"CONNECTED\""), GF(",\"CLOSED\""), GF(",\"CLOSING\""), GF(",\"REMOTE CLOSING\""), GF(",\"INITIAL\""));
+    waitResponse();
+    return 1 == res;
+  }
+#endif // TINY_GSM_NO_GPRS
+
+  enum AsyncOp
+  {
+    ASYNC_NETWORK,
+    ASYNC_GPRS,
+    ASYNC_CONNECT,
+  };
+
+  bool asyncBegin(AsyncOp op, uint32_t timeout)
+  {
+    if (async_status == AsyncStatus::PENDING)
+    {
+      return false;
+    }
+    async_op = op;
+    async_step = 0;
+    async_start = millis();
+    async_timeout = timeout;
+    async_pause = false;
+    async_status = AsyncStatus::PENDING;
+    // Otherwise it starts once the queued command in flight is done
+    if (!async_running)
+    {
+      asyncCommand();
+    }
+    return true;
+  }
+
+  void asyncFinish(AsyncStatus status)
+  {
+    async_status = status;
+    async_running = false;
+  }
+
+  // Parses at most TINY_GSM_ASYNC_SLICE bytes of the answer in flight,
+  // or starts the next command if none is
+  void asyncPoll()
+  {
+    if (!async_running)
+    {
+      asyncNext();
+    }
+    if (!async_running)
+    {
+      return;
+    }
+    for (int n = TINY_GSM_ASYNC_SLICE; n > 0 && stream.available() > 0; n--)
+    {
+      int a = stream.read();
+      if (a <= 0)
+        continue; // Skip 0x00 bytes, just in case
+      async_data.push((char)a);
+      uint8_t match = matcher.feed(async_data);
+      if (!match)
+      {
+        continue;
+      }
+      else if (match <= 5)
+      {
+        asyncResult(match);
+        return;
+      }
+      if (urcs.dispatch(match - 6, stream, async_data))
+      {
+        async_data.clear();
+      }
+      matcher.load(async_expect[0], async_expect[1], async_expect[2], async_expect[3],
+                   async_expect[4], urcs.patterns(), urcs.size());
+    }
+    if (millis() - async_sent >= async_wait)
+    {
+      asyncResult(0);
+    }
+  }
+
+  // Lets the command in flight finish before a blocking command, which
+  // would otherwise take its answer. From inside pollAsync() (a URC handler)
+  // that is not possible, and the blocking command is rejected
+  bool asyncWait()
+  {
+    if (async_polling)
+    {
+      return !async_running;
+    }
+    while (async_running)
+    {
+      pollAsync();
+      TINY_GSM_YIELD();
+    }
+    return true;
+  }
+
+  // Starts what comes next: the begin*() operation, unless it pauses,
+  // or else the first queued command
+  void asyncNext()
+  {
+    if (async_status == AsyncStatus::PENDING &&
+        (!async_pause || millis() - async_resume >= 250))
+    {
+      async_pause = false;
+      asyncCommand();
+      return;
+    }
+    if (commands.empty())
+    {
+      return;
+    }
+    TinyGsmCommand &c = commands.front();
+    sendAT(c.cmd);
+    asyncExpect(c.timeout, false, c.r1, c.r2, c.r3);
+    commands.sent();
+    async_queued = true;
+  }
+
+  // Arms the matcher for the response to the command just sent.
+  // If must is set, anything but r1 fails the operation
+  void asyncExpect(uint32_t timeout, bool must,
+                   GsmConstStr r1 = GFP(GSM_OK), GsmConstStr r2 = GFP(GSM_ERROR),
+                   GsmConstStr r3 = NULL, GsmConstStr r4 = NULL, GsmConstStr r5 = NULL)
+  {
+    async_expect[0] = r1;
+    async_expect[1] = r2;
+    async_expect[2] = r3;
+    async_expect[3] = r4;
+    async_expect[4] = r5;
+    matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
+    async_data.clear();
+    async_sent = millis();
+    async_wait = timeout;
+    async_must = must;
+    async_running = true;
+  }
+
+  // Sends the command of the current step, skipping those that do not apply
+  void asyncCommand()
+  {
+    for (;;)
+    {
+      bool sent;
+      switch (async_op)
+      {
+      case ASYNC_NETWORK:
+        sent = asyncNetworkStep();
+        break;
+#ifndef TINY_GSM_NO_GPRS
+      case ASYNC_GPRS:
+        sent = asyncGprsStep();
+        break;
+      case ASYNC_CONNECT:
+        sent = asyncConnectStep();
+        break;
+#endif // TINY_GSM_NO_GPRS
+      default:
+        sent = false;
+        async_step = 0xFF;
+        break;
+      }
+      if (sent)
+      {
+        return;
+      }
+      if (async_step == 0xFF)
+      {
+        asyncFinish(AsyncStatus::DONE);
+        return;
+      }
+      async_step++;
+    }
+  }
+
+  // Handles the response to the command in flight, index 0 is a timeout
+  void asyncResult(uint8_t index)
+  {
+    async_running = false;
+    TINY_GSM_STAT(received(index, index && async_data.endsWith(GFP(GSM_ERROR))));
+    if (async_queued)
+    {
+      // Popped first, so the callback may queue more
+      TinyGsmCommand c = commands.front();
+      commands.pop();
+      async_queued = false;
+      if (c.callback)
+      {
+        c.callback(c.arg, index, async_data);
+      }
+    }
+    else
+    {
+      asyncStepResult(index);
+    }
+  }
+
+  void asyncStepResult(uint8_t index)
+  {
+    switch (async_op)
+    {
+    case ASYNC_NETWORK:
+    {
+      if (index == 1)
+      {
+        const char *p = strstr(async_buf, "+CREG:");
+        p = p ? strchr(p, ',') : NULL;
+        int status = p ? atoi(p + 1) : REG_UNKNOWN;
+        if (status == REG_OK_HOME || status == REG_OK_ROAMING)
+        {
+          asyncFinish(AsyncStatus::DONE);
+          return;
+        }
+      }
+      if (millis() - async_start >= async_timeout)
+      {
+        asyncFinish(AsyncStatus::FAILED);
+        return;
+      }
+      // Ask again in 250 ms, like waitForNetwork()
+      async_pause = true;
+      async_resume = millis();
+      return;
+    }
+#ifndef TINY_GSM_NO_GPRS
+    case ASYNC_GPRS:
+      if (async_step == 14)
+      {
+        // Same check as modemQuickSend()
+        quick_send = index == 1 && strstr(async_buf, "+CIPQSEND: 1");
+      }
+      break;
+    case ASYNC_CONNECT:
+      if (async_step == 1)
+      {
+        // The outcome comes later as a URC, see handleConnect()
+        GsmClient *sock = sockets[async_mux];
+        sock->sock_connected = false;
+        sock->sock_opening = (index == 1);
+        sock->prev_check = millis();
+        if (index != 1)
+        {
+          asyncConnectDone();
+          return;
+        }
+      }
+      break;
+#endif // TINY_GSM_NO_GPRS
+    default:
+      break;
+    }
+    if (async_must && index != 1)
+    {
+      asyncFinish(AsyncStatus::FAILED);
+      return;
+    }
+    // Sent by the next pollAsync(), the sockets may have their turn first
+    async_step++;
+  }
+
+  bool asyncNetworkStep()
+  {
+    sendAT(GF("+CREG?"));
+    asyncExpect(1000L, false);
+    return true;
+  }
+
+#ifndef TINY_GSM_NO_GPRS
+  // Same commands as gprsDisconnect() and gprsConnect()
+  bool asyncGprsStep()
+  {
+    switch (async_step)
+    {
+    case 0:
+      sendAT(GF("+CIPSHUT"));
+      asyncExpect(60000L, false);
+      return true;
+    case 1:
+      sendAT(GF("+CGATT=0"));
+      asyncExpect(60000L, false);
+      return true;
+    case 2:
+      sendAT(GF("+SAPBR=3,1,\"Contype\",\"GPRS\""));
+      asyncExpect(1000L, false);
+      return true;
+    case 3:
+      sendAT(GF("+SAPBR=3,1,\"APN\",\""), async_apn, '"');
+      asyncExpect(1000L, false);
+      return true;
+    case 4:
+      if (!async_user || !strlen(async_user))
+      {
+        return false;
+      }
+      sendAT(GF("+SAPBR=3,1,\"USER\",\""), async_user, '"');
+      asyncExpect(1000L, false);
+      return true;
+    case 5:
+      if (!async_pwd || !strlen(async_pwd))
+      {
+        return false;
+      }
+      sendAT(GF("+SAPBR=3,1,\"PWD\",\""), async_pwd, '"');
+      asyncExpect(1000L, false);
+      return true;
+    case 6:
+      sendAT(GF("+CGDCONT=1,\"IP\",\""), async_apn, '"');
+      asyncExpect(1000L, false);
+      return true;
+    case 7:
+      sendAT(GF("+CGACT=1,1"));
+      asyncExpect(60000L, false);
+      return true;
+    case 8:
+      sendAT(GF("+SAPBR=1,1"));
+      asyncExpect(85000L, false);
+      return true;
+    case 9:
+      sendAT(GF("+SAPBR=2,1"));
+      asyncExpect(30000L, true);
+      return true;
+    case 10:
+      sendAT(GF("+CGATT=1"));
+      asyncExpect(60000L, true);
+      return true;
+    case 11:
+      sendAT(GF("+CIPMUX="), transparent ? 0 : 1);
+      asyncExpect(1000L, true);
+      return true;
+    case 12:
+      sendAT(GF("+CIPMODE="), transparent ? 1 : 0);
+      asyncExpect(1000L, transparent);
+      return true;
+    case 13:
+      if (transparent)
+      {
+        return false;
+      }
+      sendAT(GF("+CIPQSEND=1"));
+      asyncExpect(1000L, false);
+      return true;
+    case 14:
+      if (transparent)
+      {
+        return false;
+      }
+      sendAT(GF("+CIPQSEND?"));
+      asyncExpect(1000L, false);
+      return true;
+    case 15:
+      if (transparent)
+      {
+        return false;
+      }
+      sendAT(GF("+CIPRXGET=1"));
+      asyncExpect(1000L, true);
+      return true;
+    case 16:
+      sendAT(GF("+CSTT=\""), async_apn, GF("\",\""), async_user, GF("\",\""), async_pwd, GF("\""));
+      asyncExpect(60000L, true);
+      return true;
+    case 17:
+      sendAT(GF("+CIICR"));
+      asyncExpect(60000L, true);
+      return true;
+    case 18:
+      sendAT(GF("+CIFSR;E0"));
+      asyncExpect(10000L, true);
+      return true;
+    case 19:
+      sendAT(GF("+CDNSCFG=\"8.8.8.8\",\"8.8.4.4\""));
+      asyncExpect(1000L, true);
+      return true;
+    default:
+      async_step = 0xFF;
+      return false;
+    }
+  }
+
+  // Same commands as modemConnect()
+  bool asyncConnectStep()
+  {
+    switch (async_step)
+    {
+    case 0:
+#if !defined(TINY_GSM_MODEM_SIM900)
+      sendAT(GF("+CIPSSL="), async_ssl);
+      asyncExpect(1000L, async_ssl);
+      return true;
+#else
+      return false;
+#endif
+    case 1:
+      // The 75 s connect limit starts here, so SSL gets as long as TCP
+      async_start = millis();
+      sendAT(GF("+CIPSTART="), async_mux, ',', GF("\"TCP"), GF("\",\""), async_host, GF("\","), async_port);
+      asyncExpect(1000L, true);
+      return true;
+    case 2:
+      // Nothing in flight while the socket opens, handleConnect() ends it
+      if (sockets[async_mux]->sock_opening)
+      {
+        if (millis() - async_start < 75000L)
+        {
+          async_pause = true;
+          async_resume = millis();
+          return true;
+        }
+        // Give up, like modemWaitConnections()
+        sockets[async_mux]->sock_opening = false;
+        sendAT(GF("+CIPCLOSE="), async_mux);
+        asyncExpect(1000L, false, GFP(GSM_OK), GFP(GSM_ERROR), GFP(GSM_URC_CLOSE_OK));
+        return true;
+      }
+      asyncConnectDone();
+      return true;
+    default:
+      asyncConnectDone();
+      return true;
+    }
+  }
+
+  // Ends connectAsync() with the outcome of the socket
+  void asyncConnectDone()
+  {
+    bool ok = sockets[async_mux]->sock_connected;
+    if (!ok && async_host == async_addr)
+    {
+      dns.remove(async_name); // The host may have moved, look it up again next time
+    }
+    asyncFinish(ok ? AsyncStatus::DONE : AsyncStatus::FAILED);
+  }
+
+  // State of connectAsync() for one socket, whichever operation runs.
+  // Runs maintain(), the outcome comes as a URC while nothing is in flight
+  AsyncStatus pollConnect(uint8_t mux)
+  {
+    maintain();
+    if (async_op == ASYNC_CONNECT && async_mux == mux)
+    {
+      return async_status;
+    }
+    return sockets[mux]->sock_connected ? AsyncStatus::DONE : AsyncStatus::IDLE;
+  }
+
+  bool beginConnect(const char *host, uint16_t port, uint8_t mux, bool ssl = false)
+  {
+    if (async_status == AsyncStatus::PENDING)
+    {
+      return false;
+    }
+    IPAddress ip;
+    async_name = host;
+    async_host = host;
+    if (!ssl && dns.lookup(host, ip)) // SSL goes by name, for SNI
+    {
+      TinyGsmIpToString(ip).toCharArray(async_addr, sizeof(async_addr));
+      async_host = async_addr;
+    }
+    async_port = port;
+    async_mux = mux;
+    async_ssl = ssl;
+    return asyncBegin(ASYNC_CONNECT, 0);
+  }
+#endif // TINY_GSM_NO_GPRS
+
+public:
+  /* Utilities */
+
+  template <typename T>
+  void streamWrite(T last)
+  {
+    stream.print(last);
+  }
+
+  template <typename T, typename... Args>
+  void streamWrite(T head, Args... tail)
+  {
+    stream.print(head);
+    streamWrite(tail...);
+  }
 
   bool streamSkipUntil(const char c, const unsigned long timeout = 3000L)
   {
@@ -1770,14 +3085,25 @@ public:
   template <typename... Args>
   void sendAT(Args... cmd)
   {
+    if (!asyncWait())
+    {
+      DBG("### Busy, rejected:", cmd...);
+      return;
+    }
+#ifndef TINY_GSM_NO_GPRS
+    if (data_mode)
+    {
+      escapeDataMode();
+    }
+#endif // TINY_GSM_NO_GPRS
+    TINY_GSM_STAT(sent(cmd...));
     streamWrite("AT", cmd..., GSM_NL);
     stream.flush();
     TINY_GSM_YIELD();
     //DBG("### AT:", cmd...);
   }
 
-  // TODO: Optimize this!
-  uint8_t waitResponse(uint32_t timeout, String &data,
+  uint8_t waitResponse(uint32_t timeout, TinyGsmResponse& data,
                        GsmConstStr r1 = GFP(GSM_OK), GsmConstStr r2 = GFP(GSM_ERROR),
                        GsmConstStr r3 = NULL, GsmConstStr r4 = NULL, GsmConstStr r5 = NULL)
   {
@@ -1787,7 +3113,11 @@ public:
     String r4s(r4); r4s.trim();
     String r5s(r5); r5s.trim();
     DBG("### ..:", r1s, ",", r2s, ",", r3s, ",", r4s, ",", r5s);*/
-    data.reserve(64);
+    if (!asyncWait())
+    {
+      return 0;
+    }
+    matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
     int index = 0;
     unsigned long startMillis = millis();
     do
@@ -1798,95 +3128,54 @@ public:
         int a = stream.read();
         if (a <= 0)
           continue; // Skip 0x00 bytes, just in case
-        data += (char)a;
-        // Handling Automatic Updates first 
-        if(data.endsWith(GF(GSM_NL "+CMTI:"))){
-          String mem = stream.readStringUntil(',');
-          unsigned int index = stream.readStringUntil('\n').toInt();
-
-          DBG("New Message: " ,mem, index);
-          if(sms_callback!= NULL){
-            sms_callback(index);
-          }
-          data = "";
-        }
-
-        else if (r1 && data.endsWith(r1))
+        data.push((char)a);
+        uint8_t match = matcher.feed(data);
+        if (!match)
         {
-          index = 1;
-          goto finish;
-        }
-        else if (r2 && data.endsWith(r2))
-        {
-          index = 2;
-          goto finish;
-        }
-        else if (r3 && data.endsWith(r3))
-        {
-          index = 3;
-          goto finish;
+          continue;
         }
-        else if (r4 && data.endsWith(r4))
+        else if (match <= 5)
         {
-          index = 4;
+          index = match;
           goto finish;
         }
-        else if (r5 && data.endsWith(r5))
+        // Handling Automatic Updates
+        if (urcs.dispatch(match - 6, stream, data))
         {
-          index = 5;
-          goto finish;
+          data.clear();
         }
-#ifndef TINY_GSM_NO_GPRS
-        else if (data.endsWith(GF(GSM_NL "+CIPRXGET:")))
-        {
-          String mode = stream.readStringUntil(',');
-          if (mode.toInt() == 1)
-          {
-            int mux = stream.readStringUntil('\n').toInt();
-            if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux])
-            {
-              sockets[mux]->got_data = true;
-            }
-            data = "";
-          }
-          else
-          {
-            data += mode;
-          }
-        }
-        else if (data.endsWith(GF("CLOSED" GSM_NL)))
-        {
-          int nl = data.lastIndexOf(GSM_NL, data.length() - 8);
-          int coma = data.indexOf(',', nl + 2);
-          int mux = data.substring(nl + 2, coma).toInt();
-          if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux])
-          {
-            sockets[mux]->sock_connected = false;
-          }
-          data = "";
-          DBG("### Closed: ", mux);
-        }
-#endif // TINY_GSM_NO_GPRS
+        // The handler may have sent commands of its own, which loaded theirs
+        matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
       }
     } while (millis() - startMillis < timeout);
   finish:
+    TINY_GSM_STAT(received(index, index && data.endsWith(GFP(GSM_ERROR))));
     if (!index)
     {
       data.trim();
       if (data.length())
       {
-        DBG("### Unhandled:", data);
+        DBG("### Unhandled:", data.c_str());
       }
-      data = "";
+      data.clear();
     }
     return index;
   }
 
+  uint8_t waitResponse(uint32_t timeout, String& data,
+                       GsmConstStr r1 = GFP(GSM_OK), GsmConstStr r2 = GFP(GSM_ERROR),
+                       GsmConstStr r3 = NULL, GsmConstStr r4 = NULL, GsmConstStr r5 = NULL)
+  {
+    data.reserve(64);
+    TinyGsmResponse resp(data);
+    return waitResponse(timeout, resp, r1, r2, r3, r4, r5);
+  }
+
   uint8_t waitResponse(uint32_t timeout,
                        GsmConstStr r1 = GFP(GSM_OK), GsmConstStr r2 = GFP(GSM_ERROR),
                        GsmConstStr r3 = NULL, GsmConstStr r4 = NULL, GsmConstStr r5 = NULL)
   {
-    String data;
+    TinyGsmResponse data;
     return waitResponse(timeout, data, r1, r2, r3, r4, r5);
   }
 
@@ -1899,9 +3188,158 @@ public:
 public:
   Stream &stream;
 
+#if defined(TINY_GSM_STATS)
+  // Command latencies and socket traffic, see TinyGsmStats
+  TinyGsmStats &getStats()
+  {
+    return stats;
+  }
+#endif
+
 protected:
+#if defined(TINY_GSM_STATS)
+  TinyGsmStats stats;
+#endif
 #ifndef TINY_GSM_NO_GPRS
   GsmClient *sockets[TINY_GSM_MUX_COUNT];
+  GsmClientTransparent *transparent_sock;
+  bool transparent;
+  bool quick_send; // +CIPQSEND=1 took effect
+  bool data_mode;
+  uint32_t data_last;
+  TinyGsmDnsCache dns;
+#endif // TINY_GSM_NO_GPRS
+  TinyGsmMatcher matcher;
+  TinyGsmUrcs urcs;
+
+  // State of the non-blocking operation
+  AsyncStatus async_status;
+  uint8_t async_op;
+  uint8_t async_step;
+  bool async_must;
+  bool async_pause;
+  bool async_running;
+  bool async_queued;
+  bool async_polling;
+  uint32_t async_start;
+  uint32_t async_timeout;
+  uint32_t async_resume;
+  uint32_t async_sent;
+  uint32_t async_wait;
+  GsmConstStr async_expect[5];
+  char async_buf[TINY_GSM_ASYNC_BUFFER];
+  TinyGsmCommandQueue commands;
+  TinyGsmResponse async_data;
+#ifndef TINY_GSM_NO_GPRS
+  const char *async_apn;
+  const char *async_user;
+  const char *async_pwd;
+  const char *async_name;
+  const char *async_host;
+  char async_addr[16];
+  uint16_t async_port;
+  uint8_t async_mux;
+  bool async_ssl;
+#endif // TINY_GSM_NO_GPRS
+
+  static void handleCmti(void *arg, Stream &stream, TinyGsmResponse &data)
+  {
+    TinyGsmSim800 *modem = static_cast<TinyGsmSim800 *>(arg);
+    String mem = stream.readStringUntil(',');
+    unsigned int index = stream.readStringUntil('\n').toInt();
+
+    DBG("New Message: " ,mem, index);
+    if(modem->sms_callback!= NULL){
+      modem->sms_callback(index);
+    }
+  }
+
+#ifndef TINY_GSM_NO_GPRS
+  static void handleCipRxGet(void *arg, Stream &stream, TinyGsmResponse &data)
+  {
+    TinyGsmSim800 *modem = static_cast<TinyGsmSim800 *>(arg);
+    String mode = stream.readStringUntil(',');
+    if (mode.toInt() != 1)
+    {
+      // The answer to a +CIPRXGET command nobody waits for, keep it
+      for (unsigned int i = 0; i < mode.length(); i++)
+      {
+        data.push(mode[i]);
+      }
+      data.push(',');
+      return;
+    }
+    int mux = stream.readStringUntil('\n').toInt();
+    if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux])
+    {
+      modem->sockets[mux]->got_data = true;
+      modem->sockets[mux]->prev_check = millis();
+    }
+  }
+
+  static void handleClosed(void *arg, Stream &stream, TinyGsmResponse &data)
+  {
+    TinyGsmSim800 *modem = static_cast<TinyGsmSim800 *>(arg);
+    int mux = data.fromEnd(11) - '0'; // "<n>, CLOSED\r\n"
+    if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux])
+    {
+      modem->sockets[mux]->sock_connected = false;
+      modem->sockets[mux]->sock_unacked = 0;
+    }
+    DBG("### Closed: ", mux);
+  }
+
+  static void handleDataAccept(void *arg, Stream &stream, TinyGsmResponse &data)
+  {
+    static_cast<TinyGsmSim800 *>(arg)->modemDataAccept();
+  }
+
+  // "<n>, SEND FAIL" for a quick send that was already reported as written
+  static void handleSendFail(void *arg, Stream &stream, TinyGsmResponse &data)
+  {
+    TinyGsmSim800 *modem = static_cast<TinyGsmSim800 *>(arg);
+    int mux = data.fromEnd(14) - '0';
+    if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux])
+    {
+      // Its DATA ACCEPT never comes
+      modem->sockets[mux]->sock_unacked = 0;
+      modem->sockets[mux]->setWriteError();
+    }
+    DBG("### Send failed:", mux);
+  }
+
+  static void handleConnect(void *arg, Stream &stream, TinyGsmResponse &data)
+  {
+    TinyGsmSim800 *modem = static_cast<TinyGsmSim800 *>(arg);
+    // "<n>, CONNECT OK\r\n", "<n>, CONNECT FAIL\r\n", or "<n>, CLOSE OK\r\n"
+    // when the TLS handshake failed
+    bool ok = data.endsWith(GFP(GSM_URC_CONNECT_OK));
+    int mux;
+    if (ok)
+    {
+      mux = data.fromEnd(15) - '0';
+    }
+    else if (data.endsWith(GFP(GSM_URC_CONNECT_FAIL)))
+    {
+      mux = data.fromEnd(17) - '0';
+    }
+    else
+    {
+      mux = data.fromEnd(13) - '0';
+    }
+    if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux])
+    {
+      modem->sockets[mux]->sock_opening = false;
+      modem->sockets[mux]->sock_connected = ok;
+      modem->sockets[mux]->prev_check = millis();
+      if (modem->async_status == AsyncStatus::PENDING && modem->async_op == ASYNC_CONNECT &&
+          modem->async_mux == mux && modem->async_step == 2)
+      {
+        modem->asyncConnectDone();
+      }
+    }
+    DBG("### Connect:", mux, ok);
+  }
 #endif // TINY_GSM_NO_GPRS
 
   bool changeCharacterSet(const String &alphabet)
@@ -17,12 +17,18 @@
 
 #define TINY_GSM_MUX_COUNT 5
 
+// The driver's own URC handlers, and the matcher nodes their prefixes take
+#define TINY_GSM_URC_BUILTIN 2
+#define TINY_GSM_URC_BUILTIN_NODES 13
+
 #include <TinyGsmCommon.h>
 
 #define GSM_NL "\r\n"
 static const char GSM_OK[] TINY_GSM_PROGMEM = "OK" GSM_NL;
 static const char GSM_ERROR[] TINY_GSM_PROGMEM = "ERROR" GSM_NL;
 static const char GSM_CME_ERROR[] TINY_GSM_PROGMEM = GSM_NL "+CME ERROR:";
+static const char GSM_URC_UUSORD[] TINY_GSM_PROGMEM = GSM_NL "+UUSORD:";
+static const char GSM_URC_UUSOCL[] TINY_GSM_PROGMEM = GSM_NL "+UUSOCL:";
 
 enum SimStatus {
   SIM_ERROR = 0,
@@ -83,25 +89,19 @@ public:
     stop();
     TINY_GSM_YIELD();
     rx.clear();
+    clearWriteError();
     sock_connected = at->modemConnect(host, port, &mux);
     at->sockets[mux] = this;
     return sock_connected;
   }
 
   virtual int connect(IPAddress ip, uint16_t port) {
-    String host; host.reserve(16);
-    host += ip[0];
-    host += ".";
-    host += ip[1];
-    host += ".";
-    host += ip[2];
-    host += ".";
-    host += ip[3];
-    return connect(host.c_str(), port);
+    return connect(TinyGsmIpToString(ip).c_str(), port);
   }
 
   virtual void stop() {
     TINY_GSM_YIELD();
+    flushTx();
     at->sendAT(GF("+USOCL="), mux);
     sock_connected = false;
     at->waitResponse();
@@ -110,6 +110,18 @@ public:
 
   virtual size_t write(const uint8_t *buf, size_t size) {
     TINY_GSM_YIELD();
+    if (!sock_connected || getWriteError()) {
+      return 0;
+    }
+    if (tx.append(buf, size)) {
+      return size;
+    }
+    if (!flushTx()) {
+      return 0;
+    }
+    if (tx.append(buf, size)) {
+      return size;
+    }
     at->maintain();
     return at->modemSend(buf, size, mux);
   }
@@ -125,6 +137,7 @@ public:
 
   virtual int available() {
     TINY_GSM_YIELD();
+    flushTx();
     if (!rx.size() && sock_connected) {
       at->maintain();
     }
@@ -133,6 +146,7 @@ public:
 
   virtual int read(uint8_t *buf, size_t size) {
     TINY_GSM_YIELD();
+    flushTx();
     at->maintain();
     size_t cnt = 0;
     while (cnt < size) {
@@ -143,13 +157,21 @@ public:
         cnt += chunk;
         continue;
       }
-      // TODO: Read directly into user buffer?
       at->maintain();
-      if (sock_available > 0) {
-        sock_available -= at->modemRead(TinyGsmMin((uint16_t)rx.free(), sock_available), mux);
-      } else {
+      if (sock_available == 0) {
         break;
       }
+      // Large reads go straight into the caller's buffer,
+      // the fifo only keeps what a small read leaves over
+      if (size - cnt >= (size_t)rx.free()) {
+        size_t len = at->modemRead(TinyGsmMin(size - cnt, (size_t)sock_available), mux, buf);
+        sock_available -= len;
+        len = TinyGsmMin(len, size - cnt);
+        buf += len;
+        cnt += len;
+      } else {
+        sock_available -= at->modemRead(TinyGsmMin((uint16_t)rx.free(), sock_available), mux);
+      }
     }
     return cnt;
   }
@@ -162,8 +184,26 @@ public:
     return -1;
   }
 
-  virtual int peek() { return -1; } //TODO
-  virtual void flush() { at->stream.flush(); }
+  virtual int peek() {
+    flushTx();
+    if (!rx.size()) {
+      at->maintain();
+      // Refill the fifo, without taking more than it can hold
+      if (sock_available > 0) {
+        sock_available -= at->modemRead(TinyGsmMin((uint16_t)rx.free(), sock_available), mux);
+      }
+    }
+    const uint8_t* p;
+    if (rx.peek(p) > 0) {
+      return *p;
+    }
+    return -1;
+  }
+
+  virtual void flush() {
+    flushTx();
+    at->stream.flush();
+  }
 
   virtual uint8_t connected() {
     if (available()) {
@@ -180,12 +220,26 @@ public:
   String remoteIP() TINY_GSM_ATTR_NOT_IMPLEMENTED;
 
 private:
+  // Sends what write() collected, see TinyGsmTxBuffer
+  bool flushTx() {
+    if (!tx.size()) {
+      return true;
+    }
+    bool ok = sock_connected && (size_t)at->modemSend(tx.data(), tx.size(), mux) == tx.size();
+    tx.clear();
+    if (!ok) {
+      setWriteError();
+    }
+    return ok;
+  }
+
   TinyGsmUBLOX* at;
   uint8_t       mux;
   uint16_t      sock_available;
   bool          sock_connected;
   bool          got_data;
   RxFifo        rx;
+  TinyGsmTxBuffer tx;
 };
 
 //============================================================================//
@@ -209,6 +263,7 @@ public:
     stop();
     TINY_GSM_YIELD();
     rx.clear();
+    clearWriteError();
     sock_connected = at->modemConnect(host, port, &mux, true);
     at->sockets[mux] = this;
     return sock_connected;
@@ -231,6 +286,26 @@ public:
     : stream(stream)
   {
     memset(sockets, 0, sizeof(sockets));
+    urcs.add(GFP(GSM_URC_UUSORD), handleUusord, this);
+    urcs.add(GFP(GSM_URC_UUSOCL), handleUusocl, this);
+  }
+
+  /*
+   * Unsolicited result codes
+   */
+
+  // The handler runs whenever a line starting with prefix arrives
+  // while the library waits for a response, e.g. in maintain()
+  bool addUrcHandler(GsmConstStr prefix, TinyGsmUrcHandler handler, void* arg = NULL) {
+    return urcs.add(prefix, handler, arg);
+  }
+
+  bool addUrcHandlers(const TinyGsmUrc* table, uint8_t count) {
+    return urcs.add(table, count);
+  }
+
+  bool removeUrcHandler(GsmConstStr prefix) {
+    return urcs.remove(prefix);
   }
 
   /*
@@ -272,16 +347,20 @@ public:
   }
 
   void maintain() {
+    // URCs first, so got_data is up to date
+    while (stream.available()) {
+      waitResponse(10, NULL, NULL);
+    }
     for (int mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
       GsmClient* sock = sockets[mux];
+      if (sock && sock->tx.idle()) {
+        sock->flushTx();
+      }
       if (sock && sock->got_data) {
         sock->got_data = false;
         sock->sock_available = modemGetAvailable(mux);
       }
     }
-    while (stream.available()) {
-      waitResponse(10, NULL, NULL);
-    }
   }
 
   bool factoryDefault() {
@@ -628,6 +707,7 @@ protected:
     delay(50);
     stream.write((uint8_t*)buff, len);
     stream.flush();
+    TINY_GSM_STAT(sentData(mux, len));
     if (waitResponse(GF(GSM_NL "+USOWR:")) != 1) {
       return 0;
     }
@@ -637,7 +717,9 @@ protected:
     return sent;
   }
 
-  size_t modemRead(size_t size, uint8_t mux) {
+  // Reads up to size bytes into buf, or into the socket fifo if buf is NULL
+  size_t modemRead(size_t size, uint8_t mux, uint8_t* buf = NULL) {
+    size = TinyGsmMin(size, (size_t)1024);
     sendAT(GF("+USORD="), mux, ',', size);
     if (waitResponse(GF(GSM_NL "+USORD:")) != 1) {
       return 0;
@@ -646,11 +728,8 @@ protected:
     size_t len = stream.readStringUntil(',').toInt();
     streamSkipUntil('\"');
 
-    for (size_t i=0; i<len; i++) {
-      while (!stream.available()) { TINY_GSM_YIELD(); }
-      char c = stream.read();
-      sockets[mux]->rx.put(c);
-    }
+    len = TinyGsmReadPayload(stream, sockets[mux]->rx, len, buf, size);
+    TINY_GSM_STAT(receivedData(mux, len));
     streamSkipUntil('\"');
     waitResponse();
     return len;
@@ -712,14 +791,14 @@ public:
 
   template<typename... Args>
   void sendAT(Args... cmd) {
+    TINY_GSM_STAT(sent(cmd...));
     streamWrite("AT", cmd..., GSM_NL);
     stream.flush();
     TINY_GSM_YIELD();
     //DBG("### AT:", cmd...);
   }
 
-  // TODO: Optimize this!
-  uint8_t waitResponse(uint32_t timeout, String& data,
+  uint8_t waitResponse(uint32_t timeout, TinyGsmResponse& data,
                        GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
                        GsmConstStr r3=GFP(GSM_CME_ERROR), GsmConstStr r4=NULL, GsmConstStr r5=NULL)
   {
@@ -729,7 +808,7 @@ public:
     String r4s(r4); r4s.trim();
     String r5s(r5); r5s.trim();
     DBG("### ..:", r1s, ",", r2s, ",", r3s, ",", r4s, ",", r5s);*/
-    data.reserve(64);
+    matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
     int index = 0;
     unsigned long startMillis = millis();
     do {
@@ -737,57 +816,48 @@ public:
       while (stream.available() > 0) {
         int a = stream.read();
         if (a < 0) continue;
-        data += (char)a;
-        if (r1 && data.endsWith(r1)) {
-          index = 1;
-          goto finish;
-        } else if (r2 && data.endsWith(r2)) {
-          index = 2;
-          goto finish;
-        } else if (r3 && data.endsWith(r3)) {
-          index = 3;
-          goto finish;
-        } else if (r4 && data.endsWith(r4)) {
-          index = 4;
-          goto finish;
-        } else if (r5 && data.endsWith(r5)) {
-          index = 5;
+        data.push((char)a);
+        uint8_t match = matcher.feed(data);
+        if (!match) {
+          continue;
+        } else if (match <= 5) {
+          index = match;
           goto finish;
-        } else if (data.endsWith(GF(GSM_NL "+UUSORD:"))) {
-          int mux = stream.readStringUntil(',').toInt();
-          streamSkipUntil('\n');
-          if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-            sockets[mux]->got_data = true;
-          }
-          data = "";
-          DBG("### Got Data:", mux);
-        } else if (data.endsWith(GF(GSM_NL "+UUSOCL:"))) {
-          int mux = stream.readStringUntil('\n').toInt();
-          if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && sockets[mux]) {
-            sockets[mux]->sock_connected = false;
-          }
-          data = "";
-          DBG("### Closed:", mux);
         }
+        if (urcs.dispatch(match - 6, stream, data)) {
+          data.clear();
+        }
+        // The handler may have sent commands of its own, which loaded theirs
+        matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
       }
     } while (millis() - startMillis < timeout);
 finish:
+    TINY_GSM_STAT(received(index, index && (data.endsWith(GFP(GSM_ERROR)) || data.endsWith(GFP(GSM_CME_ERROR)))));
     if (!index) {
       data.trim();
       if (data.length()) {
-        DBG("### Unhandled:", data);
+        DBG("### Unhandled:", data.c_str());
       }
-      data = "";
+      data.clear();
     }
     //DBG('<', index, '>');
     return index;
   }
 
+  uint8_t waitResponse(uint32_t timeout, String& data,
+                       GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
+                       GsmConstStr r3=GFP(GSM_CME_ERROR), GsmConstStr r4=NULL, GsmConstStr r5=NULL)
+  {
+    data.reserve(64);
+    TinyGsmResponse resp(data);
+    return waitResponse(timeout, resp, r1, r2, r3, r4, r5);
+  }
+
   uint8_t waitResponse(uint32_t timeout,
                        GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
                        GsmConstStr r3=GFP(GSM_CME_ERROR), GsmConstStr r4=NULL, GsmConstStr r5=NULL)
   {
-    String data;
+    TinyGsmResponse data;
     return waitResponse(timeout, data, r1, r2, r3, r4, r5);
   }
 
@@ -800,8 +870,37 @@ finish:
 public:
   Stream&       stream;
 
+#if defined(TINY_GSM_STATS)
+  // Command latencies and socket traffic, see TinyGsmStats
+  TinyGsmStats& getStats() { return stats; }
+#endif
+
 protected:
+#if defined(TINY_GSM_STATS)
+  TinyGsmStats  stats;
+#endif
   GsmClient*    sockets[TINY_GSM_MUX_COUNT];
+  TinyGsmMatcher matcher;
+  TinyGsmUrcs    urcs;
+
+  static void handleUusord(void* arg, Stream& stream, TinyGsmResponse& data) {
+    TinyGsmUBLOX* modem = static_cast<TinyGsmUBLOX*>(arg);
+    int mux = stream.readStringUntil(',').toInt();
+    modem->streamSkipUntil('\n');
+    if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux]) {
+      modem->sockets[mux]->got_data = true;
+    }
+    DBG("### Got Data:", mux);
+  }
+
+  static void handleUusocl(void* arg, Stream& stream, TinyGsmResponse& data) {
+    TinyGsmUBLOX* modem = static_cast<TinyGsmUBLOX*>(arg);
+    int mux = stream.readStringUntil('\n').toInt();
+    if (mux >= 0 && mux < TINY_GSM_MUX_COUNT && modem->sockets[mux]) {
+      modem->sockets[mux]->sock_connected = false;
+    }
+    DBG("### Closed:", mux);
+  }
 };
 
 #endif
@@ -148,12 +148,20 @@ public:
 
   virtual int read(uint8_t *buf, size_t size) {
     TINY_GSM_YIELD();
-    return at->stream.readBytes((char*)buf, size);
+    int len = at->stream.readBytes((char*)buf, size);
+#if defined(TINY_GSM_STATS)
+    at->stats.receivedData(mux, len);
+#endif
+    return len;
   }
 
   virtual int read() {
     TINY_GSM_YIELD();
-    return at->stream.read();
+    int c = at->stream.read();
+#if defined(TINY_GSM_STATS)
+    at->stats.receivedData(mux, c >= 0);
+#endif
+    return c;
   }
 
   virtual int peek() { return at->stream.peek(); }
@@ -238,6 +246,24 @@ public:
     : stream(stream)
   {}
 
+  /*
+   * Unsolicited result codes
+   */
+
+  // The handler runs whenever a line starting with prefix arrives
+  // while the library waits for a response, e.g. in maintain()
+  bool addUrcHandler(GsmConstStr prefix, TinyGsmUrcHandler handler, void* arg = NULL) {
+    return urcs.add(prefix, handler, arg);
+  }
+
+  bool addUrcHandlers(const TinyGsmUrc* table, uint8_t count) {
+    return urcs.add(table, count);
+  }
+
+  bool removeUrcHandler(GsmConstStr prefix) {
+    return urcs.remove(prefix);
+  }
+
   /*
    * Basic functions
    */
@@ -598,6 +624,19 @@ fail:
     return TinyGsmIpFromString(getLocalIP());
   }
 
+  // Looks the address of host up; connect() reuses it until TINY_GSM_DNS_TTL
+  bool resolve(const char* host, IPAddress& ip) {
+    if (dns.lookup(host, ip)) return true;
+    if (!commandMode()) return false;  // Return immediately
+    bool res = modemResolve(host, ip);
+    exitCommand();
+    return res;
+  }
+
+  void clearDnsCache() {
+    dns.clear();
+  }
+
   /*
    * GPRS functions
    */
@@ -670,6 +709,15 @@ fail:
 protected:
 
   bool modemConnect(const char* host, uint16_t port, uint8_t mux = 0, bool ssl = false) {
+    IPAddress ip;
+    // No reason to continue if we don't know the IP address
+    if (!modemResolve(host, ip)) return false;
+    return modemConnect(ip, port, mux, ssl);
+  }
+
+  // Looks the address of host up, from the cache if possible; in command mode
+  bool modemResolve(const char* host, IPAddress& ip) {
+    if (dns.lookup(host, ip)) return true;
     String strIP; strIP.reserve(16);
     unsigned long startMillis = millis();
     bool gotIP = false;
@@ -685,23 +733,15 @@ protected:
       if (!strIP.endsWith(GF("ERROR"))) gotIP = true;
       delay(100);  // short wait before trying again
     }
-    if (gotIP) {  // No reason to continue if we don't know the IP address
-      IPAddress ip = TinyGsmIpFromString(strIP);
-      return modemConnect(ip, port, mux, ssl);
-    }
-    else return false;
+    if (!gotIP) return false;
+    ip = TinyGsmIpFromString(strIP);
+    dns.store(host, ip);
+    return true;
   }
 
   bool modemConnect(IPAddress ip, uint16_t port, uint8_t mux = 0, bool ssl = false) {
     bool success = true;
-    String host; host.reserve(16);
-    host += ip[0];
-    host += ".";
-    host += ip[1];
-    host += ".";
-    host += ip[2];
-    host += ".";
-    host += ip[3];
+    String host = TinyGsmIpToString(ip);
     if (ssl) {
       sendAT(GF("IP"), 4);  // Put in SSL over TCP communication mode
       success &= (1 == waitResponse());
@@ -719,6 +759,7 @@ protected:
   int modemSend(const void* buff, size_t len, uint8_t mux = 0) {
     stream.write((uint8_t*)buff, len);
     stream.flush();
+    TINY_GSM_STAT(sentData(mux, len));
     return len;
   }
 
@@ -791,14 +832,14 @@ public:
 
   template<typename... Args>
   void sendAT(Args... cmd) {
+    TINY_GSM_STAT(sent(cmd...));
     streamWrite("AT", cmd..., GSM_NL);
     stream.flush();
     TINY_GSM_YIELD();
     //DBG("### AT:", cmd...);
   }
 
-  // TODO: Optimize this!
-  uint8_t waitResponse(uint32_t timeout, String& data,
+  uint8_t waitResponse(uint32_t timeout, TinyGsmResponse& data,
                        GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
                        GsmConstStr r3=NULL, GsmConstStr r4=NULL, GsmConstStr r5=NULL)
   {
@@ -808,7 +849,7 @@ public:
     String r4s(r4); r4s.trim();
     String r5s(r5); r5s.trim();
     DBG("### ..:", r1s, ",", r2s, ",", r3s, ",", r4s, ",", r5s);*/
-    data.reserve(16);  // Should never be getting much here for the XBee
+    matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
     int index = 0;
     unsigned long startMillis = millis();
     do {
@@ -816,51 +857,56 @@ public:
       while (stream.available() > 0) {
         int a = stream.read();
         if (a <= 0) continue; // Skip 0x00 bytes, just in case
-        data += (char)a;
-        if (r1 && data.endsWith(r1)) {
-          index = 1;
-          goto finish;
-        } else if (r2 && data.endsWith(r2)) {
-          index = 2;
-          goto finish;
-        } else if (r3 && data.endsWith(r3)) {
-          index = 3;
-          goto finish;
-        } else if (r4 && data.endsWith(r4)) {
-          index = 4;
-          goto finish;
-        } else if (r5 && data.endsWith(r5)) {
-          index = 5;
+        data.push((char)a);
+        uint8_t match = matcher.feed(data);
+        if (!match) {
+          continue;
+        } else if (match <= 5) {
+          index = match;
           goto finish;
         }
+        if (urcs.dispatch(match - 6, stream, data)) {
+          data.clear();
+        }
+        // The handler may have sent commands of its own, which loaded theirs
+        matcher.load(r1, r2, r3, r4, r5, urcs.patterns(), urcs.size());
       }
     } while (millis() - startMillis < timeout);
 finish:
+    TINY_GSM_STAT(received(index, index && data.endsWith(GFP(GSM_ERROR))));
+    data.trim();
     if (!index) {
-      data.trim();
-      data.replace(GSM_NL GSM_NL, GSM_NL);
-      data.replace(GSM_NL, "\r\n    ");
       if (data.length()) {
-        DBG("### Unhandled:", data, "\r\n");
+#if defined(TINY_GSM_DEBUG)
+        String text(data.c_str());
+        text.replace(GSM_NL GSM_NL, GSM_NL);
+        text.replace(GSM_NL, "\r\n    ");
+        DBG("### Unhandled:", text, "\r\n");
+#endif
       } else {
         DBG("### NO RESPONSE!\r\n");
       }
-    } else {
-      data.trim();
-      data.replace(GSM_NL GSM_NL, GSM_NL);
-      data.replace(GSM_NL, "\r\n    ");
-      if (data.length()) {
-        // DBG("<<< ", data);
-      }
     }
     return index;
   }
 
+  uint8_t waitResponse(uint32_t timeout, String& data,
+                       GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
+                       GsmConstStr r3=NULL, GsmConstStr r4=NULL, GsmConstStr r5=NULL)
+  {
+    data.reserve(16);  // Should never be getting much here for the XBee
+    TinyGsmResponse resp(data);
+    uint8_t index = waitResponse(timeout, resp, r1, r2, r3, r4, r5);
+    data.replace(GSM_NL GSM_NL, GSM_NL);
+    data.replace(GSM_NL, "\r\n    ");
+    return index;
+  }
+
   uint8_t waitResponse(uint32_t timeout,
                        GsmConstStr r1=GFP(GSM_OK), GsmConstStr r2=GFP(GSM_ERROR),
                        GsmConstStr r3=NULL, GsmConstStr r4=NULL, GsmConstStr r5=NULL)
   {
-    String data;
+    TinyGsmResponse data;
     return waitResponse(timeout, data, r1, r2, r3, r4, r5);
   }
 
@@ -873,10 +919,21 @@ finish:
 public:
   Stream&       stream;
 
+#if defined(TINY_GSM_STATS)
+  // Command latencies and socket traffic, see TinyGsmStats
+  TinyGsmStats& getStats() { return stats; }
+#endif
+
 protected:
+#if defined(TINY_GSM_STATS)
+  TinyGsmStats  stats;
+#endif
   int           guardTime;
   XBeeType      beeType;
   GsmClient*    sockets[TINY_GSM_MUX_COUNT];
+  TinyGsmMatcher matcher;
+  TinyGsmUrcs    urcs;
+  TinyGsmDnsCache dns;
 };
 
 #endif
@@ -0,0 +1,415 @@
+/**
+ * @file       TinyGsmCmux.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * GSM 07.10 multiplexer (basic option), as supported by SIM800 and BG96.
+ * Splits the modem UART into virtual serial ports (DLCIs), each of which
+ * is a Stream a driver instance can run on:
+ *
+ *   TinyGsm modem(SerialAT);
+ *   modem.init();                       // On the plain UART, see below
+ *   TinyGsmCmux cmux(SerialAT);
+ *   cmux.begin(2);                      // AT+CMUX=0, opens DLCI 1 and 2
+ *   TinyGsm control(cmux.channel(1));   // network, SMS, signal quality
+ *   TinyGsm data(cmux.channel(2));      // sockets
+ *
+ * A long command on one channel then no longer holds up the others,
+ * e.g. a connect pending on the data channel (connectStart(), or
+ * connectAsync() and pollConnect()) while the control channel keeps
+ * polling.
+ *
+ * All channels, and the drivers on them, belong to one task: they share
+ * the frame parser in poll(), which takes no lock. Other tasks reach the
+ * modem through that task (see TinyGsmTask).
+ *
+ * Incoming frames are demultiplexed whenever any channel is read. Once a
+ * channel has less than two frames of room left, it asks the modem to
+ * hold off (flow control bit of MSC) until it was read empty, so a channel
+ * nobody reads does not stall the others; the frame the modem may already
+ * be sending still fits. Should the modem ignore the hold, frames that do
+ * not fit are dropped and getOverflow() of the channel tells.
+ *
+ * The drivers' init(), begin() and restart() reset the modem (AT&FZ,
+ * AT+CFUN=1,1), which ends multiplexer mode. Call them on the plain UART
+ * before begin() here, never on a channel.
+ */
+
+#ifndef TinyGsmCmux_h
+#define TinyGsmCmux_h
+
+#include <TinyGsmCommon.h>
+
+#if !defined(TINY_GSM_CMUX_CHANNELS)
+  #define TINY_GSM_CMUX_CHANNELS 2
+#endif
+
+#if !defined(TINY_GSM_CMUX_BUFFER)
+  #if defined(__AVR__)
+    #define TINY_GSM_CMUX_BUFFER 256
+  #else
+    #define TINY_GSM_CMUX_BUFFER 512
+  #endif
+#endif
+
+// Maximum information field (N1); 127 keeps the length field to one byte
+#if !defined(TINY_GSM_CMUX_FRAME)
+  #define TINY_GSM_CMUX_FRAME 127
+#endif
+
+static_assert(TINY_GSM_CMUX_BUFFER >= 2 * TINY_GSM_CMUX_FRAME,
+              "TINY_GSM_CMUX_BUFFER must hold two full frames");
+
+#define TINY_GSM_CMUX_FLAG  0xF9
+#define TINY_GSM_CMUX_EA    0x01
+#define TINY_GSM_CMUX_CR    0x02
+#define TINY_GSM_CMUX_PF    0x10
+
+#define TINY_GSM_CMUX_SABM  0x2F
+#define TINY_GSM_CMUX_UA    0x63
+#define TINY_GSM_CMUX_DM    0x0F
+#define TINY_GSM_CMUX_DISC  0x43
+#define TINY_GSM_CMUX_UIH   0xEF
+
+// Control channel (DLCI 0) message types, with EA set and C/R clear
+#define TINY_GSM_CMUX_MSC   0xE1
+#define TINY_GSM_CMUX_CLD   0xC1
+
+// Frame check sequence (reversed CRC-8, x^8 + x^2 + x + 1) over the header
+static inline
+uint8_t TinyGsmCmuxFcs(const uint8_t* p, size_t n) {
+  uint8_t crc = 0xFF;
+  while (n--) {
+    crc ^= *p++;
+    for (uint8_t i = 0; i < 8; i++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xE0 : (crc >> 1);
+    }
+  }
+  return 0xFF - crc;
+}
+
+class TinyGsmCmux;
+
+class TinyGsmCmuxChannel : public Stream
+{
+  friend class TinyGsmCmux;
+  typedef TinyGsmFifo<uint8_t, TINY_GSM_CMUX_BUFFER> RxFifo;
+
+public:
+  TinyGsmCmuxChannel() : mux(NULL), dlci(0), open(false), held(false), overflow(false) {}
+
+  bool isOpen() const { return open; }
+
+  // True if received data was dropped, because the modem ignored the hold
+  bool getOverflow() const { return overflow; }
+  void clearOverflow() { overflow = false; }
+
+  virtual int available();
+  virtual int read();
+  virtual int peek();
+  virtual size_t readBytes(char* buffer, size_t length);
+  virtual size_t write(uint8_t c) { return write(&c, 1); }
+  virtual size_t write(const uint8_t* buf, size_t size);
+  virtual void flush();
+  using Print::write;
+  using Stream::readBytes;
+
+private:
+  TinyGsmCmux*  mux;
+  uint8_t       dlci;
+  bool          open;
+  bool          held;   // The modem was asked to hold off
+  bool          overflow;
+  RxFifo        rx;
+};
+
+class TinyGsmCmux
+{
+  friend class TinyGsmCmuxChannel;
+
+public:
+  explicit TinyGsmCmux(Stream& serial)
+    : serial(serial), state(FLAG), frameLen(0), framePos(0)
+  {
+    for (uint8_t i = 0; i < TINY_GSM_CMUX_CHANNELS; i++) {
+      channels[i].mux = this;
+      channels[i].dlci = i + 1;
+    }
+    memset(acked, 0, sizeof(acked));
+  }
+
+  /*
+   * Switches the modem into multiplexer mode and opens DLCI 0 (control)
+   * and DLCI 1..channels; the modem must be in command mode
+   */
+  bool begin(uint8_t count = TINY_GSM_CMUX_CHANNELS, uint32_t timeout = 3000L) {
+    if (count > TINY_GSM_CMUX_CHANNELS) return false;
+    serial.print(GF("AT+CMUX=0\r\n"));
+    serial.flush();
+    if (!waitOk(timeout)) return false;
+    for (uint8_t dlci = 0; dlci <= count; dlci++) {
+      if (!openChannel(dlci, timeout)) return false;
+    }
+    return true;
+  }
+
+  // Closes all channels and returns the modem to plain AT mode
+  void end() {
+    for (uint8_t i = 0; i < TINY_GSM_CMUX_CHANNELS; i++) {
+      if (channels[i].open) {
+        sendFrame(channels[i].dlci, TINY_GSM_CMUX_DISC | TINY_GSM_CMUX_PF, NULL, 0);
+        channels[i].open = false;
+      }
+    }
+    const uint8_t cld[] = { TINY_GSM_CMUX_CLD | TINY_GSM_CMUX_CR, TINY_GSM_CMUX_EA };
+    sendFrame(0, TINY_GSM_CMUX_UIH, cld, sizeof(cld));
+  }
+
+  // Virtual serial port of DLCI 1..TINY_GSM_CMUX_CHANNELS
+  TinyGsmCmuxChannel& channel(uint8_t dlci) {
+    return channels[dlci - 1];
+  }
+
+  // Moves received frames into the channel buffers
+  void poll() {
+    for (uint8_t i = 0; i < TINY_GSM_CMUX_CHANNELS; i++) {
+      TinyGsmCmuxChannel& ch = channels[i];
+      if (ch.held && !ch.rx.size()) {
+        ch.held = false;
+        sendStatus(ch.dlci, false);
+      }
+    }
+    while (serial.available() > 0) {
+      if (state == DATA) {
+        size_t n = TinyGsmMin((size_t)serial.available(), (size_t)(frameLen - framePos));
+        framePos += serial.readBytes((char*)frame + framePos, n);
+        if (framePos == frameLen) state = FCS;
+        continue;
+      }
+      uint8_t c = serial.read();
+      switch (state) {
+      case FLAG:
+        if (c != TINY_GSM_CMUX_FLAG) break;
+        state = ADDRESS;
+        break;
+      case ADDRESS:
+        if (c == TINY_GSM_CMUX_FLAG) break; // Closing flag of the previous frame
+        header[0] = c;
+        frameDlci = c >> 2;
+        // Not a frame after all (line noise), resync on the next flag
+        state = ((c & TINY_GSM_CMUX_EA) && frameDlci <= TINY_GSM_CMUX_CHANNELS) ? CONTROL : FLAG;
+        break;
+      case CONTROL:
+        header[1] = c;
+        switch (c & ~TINY_GSM_CMUX_PF) {
+        case TINY_GSM_CMUX_SABM:
+        case TINY_GSM_CMUX_UA:
+        case TINY_GSM_CMUX_DM:
+        case TINY_GSM_CMUX_DISC:
+        case TINY_GSM_CMUX_UIH:
+          state = LENGTH;
+          break;
+        default:
+          state = FLAG;
+          break;
+        }
+        break;
+      case LENGTH:
+        header[2] = c;
+        frameLen = c >> 1;
+        framePos = 0;
+        // Two-byte lengths only appear with an N1 above 127
+        if (!(c & TINY_GSM_CMUX_EA) || frameLen > TINY_GSM_CMUX_FRAME) {
+          state = FLAG;
+        } else {
+          state = frameLen ? DATA : FCS;
+        }
+        break;
+      case FCS:
+        state = FLAG;
+        if (c == TinyGsmCmuxFcs(header, 3)) {
+          received();
+        } else {
+          DBG("### CMUX bad FCS on DLCI", frameDlci);
+        }
+        break;
+      default:
+        state = FLAG;
+        break;
+      }
+    }
+  }
+
+protected:
+  enum State { FLAG, ADDRESS, CONTROL, LENGTH, DATA, FCS };
+
+  TinyGsmCmuxChannel* find(uint8_t dlci) {
+    if (dlci < 1 || dlci > TINY_GSM_CMUX_CHANNELS) return NULL;
+    return &channels[dlci - 1];
+  }
+
+  void received() {
+    uint8_t control = header[1] & ~TINY_GSM_CMUX_PF;
+    TinyGsmCmuxChannel* ch = find(frameDlci);
+    switch (control) {
+    case TINY_GSM_CMUX_UIH:
+      if (frameDlci == 0) {
+        control0();
+      } else if (ch && ch->open) {
+        if ((size_t)ch->rx.free() < frameLen) {
+          DBG("### CMUX overrun on DLCI", frameDlci);
+          ch->overflow = true;
+          break;
+        }
+        ch->rx.put(frame, frameLen);
+        // Room for the frame that may be on the way already
+        if (!ch->held && ch->rx.free() < 2 * TINY_GSM_CMUX_FRAME) {
+          ch->held = true;
+          sendStatus(ch->dlci, true);
+        }
+      }
+      break;
+    case TINY_GSM_CMUX_UA:
+    case TINY_GSM_CMUX_DM:
+      if (frameDlci <= TINY_GSM_CMUX_CHANNELS) {
+        acked[frameDlci] = (control == TINY_GSM_CMUX_UA) ? 1 : 2;
+      }
+      break;
+    case TINY_GSM_CMUX_DISC:
+      if (ch) ch->open = false;
+      sendFrame(frameDlci, TINY_GSM_CMUX_UA | TINY_GSM_CMUX_PF, NULL, 0);
+      break;
+    }
+  }
+
+  // Answers modem status commands, other control messages are ignored
+  void control0() {
+    if (frameLen < 2 || !(frame[0] & TINY_GSM_CMUX_CR)) return;
+    if ((frame[0] & ~TINY_GSM_CMUX_CR) == TINY_GSM_CMUX_MSC) {
+      frame[0] &= ~TINY_GSM_CMUX_CR;
+      sendFrame(0, TINY_GSM_CMUX_UIH, frame, frameLen);
+    }
+  }
+
+  bool openChannel(uint8_t dlci, uint32_t timeout) {
+    acked[dlci] = 0;
+    sendFrame(dlci, TINY_GSM_CMUX_SABM | TINY_GSM_CMUX_PF, NULL, 0);
+    for (uint32_t start = millis(); acked[dlci] == 0; ) {
+      if (millis() - start > timeout) return false;
+      poll();
+      TINY_GSM_YIELD();
+    }
+    if (acked[dlci] != 1) return false;
+    if (dlci) {
+      channels[dlci - 1].open = true;
+      channels[dlci - 1].held = false;
+      channels[dlci - 1].overflow = false;
+      channels[dlci - 1].rx.clear();
+      sendStatus(dlci, false);
+    }
+    return true;
+  }
+
+  // Ready to communicate, ready to receive, data valid; with hold set,
+  // flow control asks the modem to stop sending on the DLCI
+  void sendStatus(uint8_t dlci, bool hold) {
+    const uint8_t msc[] = { TINY_GSM_CMUX_MSC | TINY_GSM_CMUX_CR, (2 << 1) | TINY_GSM_CMUX_EA,
+                            (uint8_t)((dlci << 2) | TINY_GSM_CMUX_CR | TINY_GSM_CMUX_EA),
+                            (uint8_t)(hold ? 0x8F : 0x8D) };
+    sendFrame(0, TINY_GSM_CMUX_UIH, msc, sizeof(msc));
+  }
+
+  bool waitOk(uint32_t timeout) {
+    TinyGsmResponse data;
+    for (uint32_t start = millis(); millis() - start < timeout; ) {
+      while (serial.available() > 0) {
+        data.push((char)serial.read());
+        if (data.endsWith(GF("OK\r\n"))) return true;
+        if (data.endsWith(GF("ERROR\r\n"))) return false;
+      }
+      TINY_GSM_YIELD();
+    }
+    return false;
+  }
+
+  size_t sendFrame(uint8_t dlci, uint8_t control, const uint8_t* data, size_t len) {
+    uint8_t head[4] = {
+      TINY_GSM_CMUX_FLAG,
+      (uint8_t)((dlci << 2) | TINY_GSM_CMUX_CR | TINY_GSM_CMUX_EA),
+      control,
+      (uint8_t)((len << 1) | TINY_GSM_CMUX_EA)
+    };
+    uint8_t tail[2] = { TinyGsmCmuxFcs(head + 1, 3), TINY_GSM_CMUX_FLAG };
+    serial.write(head, sizeof(head));
+    if (len) serial.write(data, len);
+    serial.write(tail, sizeof(tail));
+    return len;
+  }
+
+  // Splits data into UIH frames of at most TINY_GSM_CMUX_FRAME bytes
+  size_t send(uint8_t dlci, const uint8_t* data, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+      size_t n = TinyGsmMin(len - sent, (size_t)TINY_GSM_CMUX_FRAME);
+      sendFrame(dlci, TINY_GSM_CMUX_UIH, data + sent, n);
+      sent += n;
+    }
+    return sent;
+  }
+
+  Stream&             serial;
+  TinyGsmCmuxChannel  channels[TINY_GSM_CMUX_CHANNELS];
+  uint8_t             acked[TINY_GSM_CMUX_CHANNELS + 1]; // 0 pending, 1 UA, 2 DM
+
+  State               state;
+  uint8_t             header[3];                        // address, control, length
+  uint8_t             frameDlci;
+  uint8_t             frameLen;
+  uint8_t             framePos;
+  uint8_t             frame[TINY_GSM_CMUX_FRAME];
+};
+
+inline int TinyGsmCmuxChannel::available() {
+  mux->poll();
+  return rx.size();
+}
+
+inline int TinyGsmCmuxChannel::read() {
+  uint8_t c;
+  mux->poll();
+  return rx.get(&c) ? c : -1;
+}
+
+inline int TinyGsmCmuxChannel::peek() {
+  const uint8_t* p;
+  mux->poll();
+  return (rx.peek(p) > 0) ? *p : -1;
+}
+
+inline size_t TinyGsmCmuxChannel::readBytes(char* buffer, size_t length) {
+  size_t cnt = 0;
+  for (uint32_t start = millis(); cnt < length && millis() - start < _timeout; ) {
+    mux->poll();
+    size_t n = rx.get((uint8_t*)buffer + cnt, length - cnt);
+    if (n) {
+      cnt += n;
+      start = millis();
+    } else {
+      TINY_GSM_YIELD();
+    }
+  }
+  return cnt;
+}
+
+inline size_t TinyGsmCmuxChannel::write(const uint8_t* buf, size_t size) {
+  if (!open) return 0;
+  return mux->send(dlci, buf, size);
+}
+
+inline void TinyGsmCmuxChannel::flush() {
+  mux->serial.flush();
+}
+
+#endif
@@ -99,6 +99,24 @@ struct Sms {
   uint8_t position;               // Index of the message in the memory
 };
 
+// Progress of a non-blocking operation, see the begin*()/poll*() functions
+enum class AsyncStatus : uint8_t {
+  IDLE    = 0,
+  PENDING = 1,
+  DONE    = 2,
+  FAILED  = 3
+};
+
+// Bytes of modem output a single poll*() call parses at most
+#if !defined(TINY_GSM_ASYNC_SLICE)
+  #define TINY_GSM_ASYNC_SLICE 64
+#endif
+
+// Bytes of a response kept for non-blocking operations and queued commands
+#if !defined(TINY_GSM_ASYNC_BUFFER)
+  #define TINY_GSM_ASYNC_BUFFER 64
+#endif
+
 template<class T>
 const T& TinyGsmMin(const T& a, const T& b)
 {
@@ -111,6 +129,712 @@ const T& TinyGsmMax(const T& a, const T& b)
     return (b < a) ? a : b;
 }
 
+static inline
+size_t TinyGsmStrLen(GsmConstStr s) {
+#if defined(__AVR__)
+  return strlen_P(reinterpret_cast<const char*>(s));
+#else
+  return strlen(s);
+#endif
+}
+
+static inline
+char TinyGsmStrChar(GsmConstStr s, size_t i) {
+#if defined(__AVR__)
+  return pgm_read_byte(reinterpret_cast<const char*>(s) + i);
+#else
+  return s[i];
+#endif
+}
+
+#if !defined(TINY_GSM_RESPONSE_WINDOW)
+  #define TINY_GSM_RESPONSE_WINDOW 32
+#endif
+
+/*
+ * Receive side of waitResponse().
+ *
+ * Patterns are matched against a fixed window holding the last
+ * TINY_GSM_RESPONSE_WINDOW bytes, so matching uses no heap. The window must
+ * be at least as long as the longest pattern (22 bytes in the bundled drivers).
+ * The text itself is only kept if a capture target is given: either a bounded
+ * buffer, which is always NUL-terminated and silently truncated, or a String.
+ */
+class TinyGsmResponse
+{
+public:
+  TinyGsmResponse()
+    : head(0), count(0), buf(NULL), size(0), len(0), truncated(false), str(NULL)
+  {}
+
+  TinyGsmResponse(char* buf, size_t size)
+    : head(0), count(0), buf(buf), size(size), len(0), truncated(false), str(NULL)
+  {
+    if (size) buf[0] = '\0';
+  }
+
+  // Appends to the String, like the String& overloads of waitResponse() did
+  explicit TinyGsmResponse(String& str)
+    : head(0), count(0), buf(NULL), size(0), len(0), truncated(false), str(&str)
+  {}
+
+  void clear() {
+    head = 0;
+    count = 0;
+    len = 0;
+    truncated = false;
+    if (size) buf[0] = '\0';
+    if (str) *str = "";
+  }
+
+  void push(char c) {
+    win[head] = c;
+    if (++head >= TINY_GSM_RESPONSE_WINDOW) head = 0;
+    if (count < TINY_GSM_RESPONSE_WINDOW) count++;
+    if (buf) {
+      if (len + 1 < size) {
+        buf[len++] = c;
+        buf[len] = '\0';
+      } else {
+        truncated = true;
+      }
+    }
+    if (str) *str += c;
+  }
+
+  bool endsWith(GsmConstStr s) const {
+    size_t n = TinyGsmStrLen(s);
+    if (n > count) return false;
+    uint16_t i = head;
+    while (n) {
+      i = i ? i - 1 : TINY_GSM_RESPONSE_WINDOW - 1;
+      if (win[i] != TinyGsmStrChar(s, --n)) return false;
+    }
+    return true;
+  }
+
+  // n-th byte from the end (1 is the last one), or 0 if it fell out of the window
+  char fromEnd(uint8_t n) const {
+    if (!n || n > count) return 0;
+    return win[(head + TINY_GSM_RESPONSE_WINDOW - n) % TINY_GSM_RESPONSE_WINDOW];
+  }
+
+  // Length of the text returned by c_str()
+  size_t length() const {
+    if (str) return str->length();
+    return buf ? len : count;
+  }
+  // True if bytes were dropped because the capture buffer was full
+  bool overflow() const { return truncated; }
+
+  // Captured text, or the window contents if nothing is captured
+  const char* c_str() {
+    if (buf) return size ? buf : "";
+    if (str) return str->c_str();
+    // Rotate the window in place, so it starts at index 0
+    for (uint16_t r = (count < TINY_GSM_RESPONSE_WINDOW) ? 0 : head; r; r--) {
+      char c = win[0];
+      memmove(win, win + 1, TINY_GSM_RESPONSE_WINDOW - 1);
+      win[TINY_GSM_RESPONSE_WINDOW - 1] = c;
+    }
+    head = count % TINY_GSM_RESPONSE_WINDOW;
+    win[count] = '\0';
+    return win;
+  }
+
+  // Strips leading and trailing whitespace from the text returned by c_str()
+  void trim() {
+    if (str) {
+      str->trim();
+    } else if (buf) {
+      if (size) len = trim(buf, len);
+    } else {
+      c_str();
+      count = trim(win, count);
+      head = count % TINY_GSM_RESPONSE_WINDOW;
+    }
+  }
+
+private:
+  static size_t trim(char* s, size_t n) {
+    while (n && isspace((unsigned char)s[n - 1])) n--;
+    size_t skip = 0;
+    while (skip < n && isspace((unsigned char)s[skip])) skip++;
+    n -= skip;
+    memmove(s, s + skip, n);
+    s[n] = '\0';
+    return n;
+  }
+
+  static_assert(TINY_GSM_RESPONSE_WINDOW > 0 && TINY_GSM_RESPONSE_WINDOW <= 0xFFFF,
+                "TINY_GSM_RESPONSE_WINDOW must be 1..65535");
+
+  char     win[TINY_GSM_RESPONSE_WINDOW + 1];
+  uint16_t head;
+  uint16_t count;
+  char*    buf;
+  size_t   size;
+  size_t   len;
+  bool     truncated;
+  String*  str;
+};
+
+// URC handlers a driver registers itself, and the automaton nodes their
+// prefixes take; set by the driver before it includes this file
+#if !defined(TINY_GSM_URC_BUILTIN)
+  #define TINY_GSM_URC_BUILTIN 0
+#endif
+
+#if !defined(TINY_GSM_URC_BUILTIN_NODES)
+  #define TINY_GSM_URC_BUILTIN_NODES 0
+#endif
+
+// Nodes left for the expected responses and the user's URCs come on top
+#if !defined(TINY_GSM_MATCHER_NODES)
+  #if defined(__AVR__)
+    #define TINY_GSM_MATCHER_NODES (64 + TINY_GSM_URC_BUILTIN_NODES)
+  #else
+    #define TINY_GSM_MATCHER_NODES (128 + TINY_GSM_URC_BUILTIN_NODES)
+  #endif
+#endif
+
+// URC handlers left for the user, on top of the driver's own
+#if !defined(TINY_GSM_URC_HANDLERS)
+  #define TINY_GSM_URC_HANDLERS 8
+#endif
+
+#define TINY_GSM_URC_SLOTS (TINY_GSM_URC_BUILTIN + TINY_GSM_URC_HANDLERS)
+
+#if !defined(TINY_GSM_MATCHER_PATTERNS)
+  #define TINY_GSM_MATCHER_PATTERNS (5 + TINY_GSM_URC_SLOTS)
+#endif
+
+/*
+ * Aho-Corasick automaton over all patterns of a waitResponse() call:
+ * the expected responses r1..r5 (ids 1..5) followed by the registered URC
+ * prefixes (ids 6..). Each received byte moves the automaton by one state
+ * (amortized over failure links), so the per-byte cost does not grow with
+ * the number of patterns.
+ *
+ * If several patterns end on the same byte, the longest one wins, so a URC
+ * such as "1, CONNECT OK" is not taken for the "OK" of another command;
+ * equal patterns go to the lowest id. The automaton is only rebuilt when
+ * the pattern pointers change, so patterns must be static strings (GF/GFP).
+ * Patterns that do not fit into TINY_GSM_MATCHER_NODES are still matched,
+ * with TinyGsmResponse::endsWith().
+ */
+class TinyGsmMatcher
+{
+public:
+  TinyGsmMatcher()
+    : count(0), nodes(0), state(0)
+  {}
+
+  void load(GsmConstStr r1, GsmConstStr r2, GsmConstStr r3, GsmConstStr r4, GsmConstStr r5,
+            const GsmConstStr* urcs = NULL, uint8_t n = 0)
+  {
+    GsmConstStr r[5] = { r1, r2, r3, r4, r5 };
+    n = TinyGsmMin(n, (uint8_t)(TINY_GSM_MATCHER_PATTERNS - 5));
+    state = 0;
+    if (nodes && count == 5 + n && !memcmp(pattern, r, sizeof(r)) &&
+        (!n || !memcmp(pattern + 5, urcs, n * sizeof(GsmConstStr))))
+    {
+      return;
+    }
+    memcpy(pattern, r, sizeof(r));
+    if (n) memcpy(pattern + 5, urcs, n * sizeof(GsmConstStr));
+    count = 5 + n;
+    build();
+  }
+
+  // Forget the bytes seen so far, e.g. after the response was cleared
+  void restart() {
+    state = 0;
+  }
+
+  // Advances by the last byte pushed into data, returns the id of the pattern it ends, or 0
+  uint8_t feed(const TinyGsmResponse& data) {
+    uint8_t c = data.fromEnd(1);
+    if (state || (first[c >> 3] & (1 << (c & 7)))) {
+      for (;;) {
+        uint8_t t = find(state, c);
+        if (t) {
+          state = t;
+          break;
+        }
+        if (!state) break;
+        state = fail[state];
+      }
+    }
+    uint8_t id = out[state];
+    for (uint8_t i = 0; i < spills; i++) {
+      uint8_t s = spill[i];
+      if ((!id || beats(s, id)) && data.endsWith(pattern[s - 1])) id = s;
+    }
+    return id;
+  }
+
+private:
+  // Whether pattern a wins over pattern b, if both end on the same byte
+  bool beats(uint8_t a, uint8_t b) const {
+    size_t la = TinyGsmStrLen(pattern[a - 1]);
+    size_t lb = TinyGsmStrLen(pattern[b - 1]);
+    return la > lb || (la == lb && a < b);
+  }
+
+  uint8_t find(uint8_t node, uint8_t c) const {
+    for (uint8_t t = child[node]; t; t = next[t]) {
+      if (key[t] == c) return t;
+    }
+    return 0;
+  }
+
+  void build() {
+    nodes = 1;
+    spills = 0;
+    child[0] = next[0] = fail[0] = out[0] = 0;
+    memset(first, 0, sizeof(first));
+
+    for (uint8_t id = 1; id <= count; id++) {
+      GsmConstStr p = pattern[id - 1];
+      if (!p) continue;
+      size_t len = TinyGsmStrLen(p);
+      if (!len) continue;
+      // Walk the shared prefix first, so a pattern is either added whole or spilled
+      uint8_t node = 0;
+      size_t i = 0;
+      for (uint8_t t; i < len && (t = find(node, TinyGsmStrChar(p, i))); i++) {
+        node = t;
+      }
+      if (len - i > (size_t)(TINY_GSM_MATCHER_NODES - nodes)) {
+        DBG("### Matcher full, slow match for", id);
+        spill[spills++] = id;
+        continue;
+      }
+      for (; i < len; i++) {
+        uint8_t t = nodes++;
+        key[t] = TinyGsmStrChar(p, i);
+        child[t] = out[t] = 0;
+        next[t] = child[node];
+        child[node] = t;
+        node = t;
+      }
+      if (!out[node] || id < out[node]) out[node] = id;
+    }
+
+    // Failure links in breadth-first order. A node only takes the output of
+    // its failure link, a shorter suffix, if no pattern ends on it
+    uint8_t queue[TINY_GSM_MATCHER_NODES];
+    uint8_t head = 0, tail = 0;
+    for (uint8_t t = child[0]; t; t = next[t]) {
+      fail[t] = 0;
+      first[key[t] >> 3] |= 1 << (key[t] & 7);
+      queue[tail++] = t;
+    }
+    while (head < tail) {
+      uint8_t u = queue[head++];
+      for (uint8_t v = child[u]; v; v = next[v]) {
+        uint8_t f = fail[u];
+        uint8_t t;
+        while (!(t = find(f, key[v])) && f) {
+          f = fail[f];
+        }
+        fail[v] = t;
+        if (!out[v]) out[v] = out[t];
+        queue[tail++] = v;
+      }
+    }
+  }
+
+  static_assert(TINY_GSM_MATCHER_NODES <= 255, "Matcher nodes are indexed by uint8_t");
+
+  GsmConstStr pattern[TINY_GSM_MATCHER_PATTERNS];
+  uint8_t     count;
+  uint8_t     spill[TINY_GSM_MATCHER_PATTERNS];
+  uint8_t     spills;
+
+  uint8_t     key[TINY_GSM_MATCHER_NODES];
+  uint8_t     child[TINY_GSM_MATCHER_NODES];  // first child, 0 if none
+  uint8_t     next[TINY_GSM_MATCHER_NODES];   // next sibling, 0 if none
+  uint8_t     fail[TINY_GSM_MATCHER_NODES];
+  uint8_t     out[TINY_GSM_MATCHER_NODES];    // longest pattern ending here, 0 if none
+  uint8_t     first[32];                      // bytes that leave the root
+  uint8_t     nodes;
+  uint8_t     state;
+};
+
+static inline
+bool TinyGsmStrEqual(GsmConstStr a, GsmConstStr b) {
+  if (a == b) return true;
+  if (!a || !b) return false;
+  for (size_t i = 0; ; i++) {
+    char c = TinyGsmStrChar(a, i);
+    if (c != TinyGsmStrChar(b, i)) return false;
+    if (!c) return true;
+  }
+}
+
+/*
+ * Handler for an unsolicited result code.
+ * Called from waitResponse() right after the prefix was received, so the rest
+ * of the URC is still in the stream; data ends with the prefix.
+ * A handler that finds the line is not its URC after all appends what it
+ * read to data, which then stays in the response.
+ */
+typedef void (*TinyGsmUrcHandler)(void* arg, Stream& stream, TinyGsmResponse& data);
+
+struct TinyGsmUrc {
+  GsmConstStr       prefix;
+  TinyGsmUrcHandler handler;
+  void*             arg;
+};
+
+/*
+ * URC handlers by prefix.
+ * The prefixes are matched by TinyGsmMatcher together with the expected
+ * responses, and the match id indexes straight into the handler table.
+ */
+class TinyGsmUrcs
+{
+public:
+  TinyGsmUrcs()
+    : count(0)
+  {}
+
+  // Adds a handler, or replaces the one already registered for the same prefix
+  bool add(GsmConstStr prefix, TinyGsmUrcHandler handler, void* arg = NULL) {
+    if (!prefix || !handler) return false;
+    uint8_t i = find(prefix);
+    if (i == count) {
+      if (count >= TINY_GSM_URC_SLOTS) return false;
+      count++;
+    }
+    prefixes[i] = prefix;
+    handlers[i] = handler;
+    args[i] = arg;
+    return true;
+  }
+
+  bool add(const TinyGsmUrc* table, uint8_t n) {
+    bool ok = true;
+    for (uint8_t i = 0; i < n; i++) {
+      ok &= add(table[i].prefix, table[i].handler, table[i].arg);
+    }
+    return ok;
+  }
+
+  bool remove(GsmConstStr prefix) {
+    uint8_t i = find(prefix);
+    if (i == count) return false;
+    for (count--; i < count; i++) {
+      prefixes[i] = prefixes[i + 1];
+      handlers[i] = handlers[i + 1];
+      args[i] = args[i + 1];
+    }
+    return true;
+  }
+
+  // Prefixes in registration order, for TinyGsmMatcher::load()
+  const GsmConstStr* patterns() const { return prefixes; }
+  uint8_t size() const { return count; }
+
+  // Runs the handler of URC i. Returns false if the handler gave the text
+  // back, by appending what it read to data: then the text stays in the
+  // response instead of being dropped
+  bool dispatch(uint8_t i, Stream& stream, TinyGsmResponse& data) {
+    if (i >= count) return true;
+    handlers[i](args[i], stream, data);
+    return data.endsWith(prefixes[i]);
+  }
+
+private:
+  uint8_t find(GsmConstStr prefix) const {
+    uint8_t i = 0;
+    while (i < count && !TinyGsmStrEqual(prefixes[i], prefix)) i++;
+    return i;
+  }
+
+  GsmConstStr       prefixes[TINY_GSM_URC_SLOTS];
+  TinyGsmUrcHandler handlers[TINY_GSM_URC_SLOTS];
+  void*             args[TINY_GSM_URC_SLOTS];
+  uint8_t           count;
+};
+
+#if !defined(TINY_GSM_COMMAND_QUEUE)
+  #if defined(__AVR__)
+    #define TINY_GSM_COMMAND_QUEUE 4
+  #else
+    #define TINY_GSM_COMMAND_QUEUE 8
+  #endif
+#endif
+
+#if !defined(TINY_GSM_COMMAND_LENGTH)
+  #define TINY_GSM_COMMAND_LENGTH 48
+#endif
+
+/*
+ * Completion of a queued command.
+ * index is the terminator that matched (1..3), or 0 on timeout; data holds
+ * the response as far as it fits into the capture buffer.
+ */
+typedef void (*TinyGsmCommandCallback)(void* arg, uint8_t index, TinyGsmResponse& data);
+
+struct TinyGsmCommand {
+  char                   cmd[TINY_GSM_COMMAND_LENGTH]; // Without the "AT"
+  GsmConstStr            r1;
+  GsmConstStr            r2;
+  GsmConstStr            r3;
+  uint32_t               timeout;
+  uint8_t                priority;
+  TinyGsmCommandCallback callback;
+  void*                  arg;
+};
+
+/*
+ * AT commands waiting to be sent, highest priority first.
+ * Commands of the same priority keep their order. Once the front command
+ * was sent, it stays in front until pop(), whatever comes in meanwhile.
+ */
+class TinyGsmCommandQueue
+{
+public:
+  TinyGsmCommandQueue()
+    : count(0), inflight(false)
+  {}
+
+  // Makes room for a command behind those of the same or higher priority,
+  // returns NULL if the queue is full
+  TinyGsmCommand* insert(uint8_t priority) {
+    if (count >= TINY_GSM_COMMAND_QUEUE) return NULL;
+    uint8_t i = count;
+    while (i > (uint8_t)inflight && items[i - 1].priority < priority) {
+      items[i] = items[i - 1];
+      i--;
+    }
+    count++;
+    items[i].priority = priority;
+    return &items[i];
+  }
+
+  TinyGsmCommand& front() { return items[0]; }
+
+  // The front command went out, its answer goes to it
+  void sent() { inflight = count > 0; }
+
+  void pop() {
+    inflight = false;
+    if (!count) return;
+    count--;
+    for (uint8_t i = 0; i < count; i++) {
+      items[i] = items[i + 1];
+    }
+  }
+
+  void clear() { count = 0; inflight = false; }
+  uint8_t size() const { return count; }
+  bool empty() const { return !count; }
+
+private:
+  TinyGsmCommand items[TINY_GSM_COMMAND_QUEUE];
+  uint8_t        count;
+  bool           inflight;
+};
+
+/*
+ * Runtime statistics, only compiled in with TINY_GSM_STATS defined.
+ * sendAT() and waitResponse() of the drivers count every command by its
+ * name ("+CIPSEND", "+CSQ", ...) and keep a histogram of the time to its
+ * first response; modemSend() and modemRead() count the bytes per socket.
+ * Call TINY_GSM_STAT(x) instead of stats.x, so the calls go away with it.
+ */
+#if defined(TINY_GSM_STATS)
+  #define TINY_GSM_STAT(x) stats.x
+#else
+  #define TINY_GSM_STAT(x)
+#endif
+
+#if defined(TINY_GSM_STATS)
+
+// Commands that are told apart, the ones after that are not counted
+#if !defined(TINY_GSM_STATS_COMMANDS)
+  #if defined(__AVR__)
+    #define TINY_GSM_STATS_COMMANDS 6
+  #else
+    #define TINY_GSM_STATS_COMMANDS 16
+  #endif
+#endif
+
+// Command names are cut to this length
+#if !defined(TINY_GSM_STATS_NAME)
+  #define TINY_GSM_STATS_NAME 10
+#endif
+
+// Latency histogram: 0 ms, then [1, 2), [2, 4) ... ms, the last one is open
+#if !defined(TINY_GSM_STATS_BUCKETS)
+  #define TINY_GSM_STATS_BUCKETS 16
+#endif
+
+struct TinyGsmCommandStats {
+  char     name[TINY_GSM_STATS_NAME + 1];
+  uint32_t count;     // Answered, including errors
+  uint32_t timeouts;
+  uint32_t errors;
+  uint32_t min;       // ms
+  uint32_t max;
+  uint32_t total;
+  uint16_t hist[TINY_GSM_STATS_BUCKETS];
+
+  uint32_t avg() const {
+    return count ? total / count : 0;
+  }
+
+  // Upper bound of the bucket that holds the p-th percentile, in ms
+  uint32_t percentile(uint8_t p) const {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < TINY_GSM_STATS_BUCKETS; i++) sum += hist[i];
+    if (!sum) return 0;
+    uint32_t need = (uint32_t)(((uint64_t)sum * p + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < TINY_GSM_STATS_BUCKETS - 1; i++) {
+      seen += hist[i];
+      if (seen >= need) return TinyGsmMin(i ? (1UL << i) - 1 : 0UL, (unsigned long)max);
+    }
+    return max;
+  }
+};
+
+class TinyGsmStats
+{
+public:
+  TinyGsmStats() {
+    reset();
+  }
+
+  void reset() {
+    count = 0;
+    current = NULL;
+    memset(tx, 0, sizeof(tx));
+    memset(rx, 0, sizeof(rx));
+  }
+
+  uint8_t commands() const { return count; }
+  const TinyGsmCommandStats& command(uint8_t i) const { return table[i]; }
+
+  const TinyGsmCommandStats* find(const char* name) const {
+    for (uint8_t i = 0; i < count; i++) {
+      if (!strcmp(table[i].name, name)) return &table[i];
+    }
+    return NULL;
+  }
+
+  uint32_t txBytes(uint8_t mux) const { return mux < TINY_GSM_MUX_COUNT ? tx[mux] : 0; }
+  uint32_t rxBytes(uint8_t mux) const { return mux < TINY_GSM_MUX_COUNT ? rx[mux] : 0; }
+
+  // One line per command and per socket that moved data
+  void print(Print& out) const {
+    for (uint8_t i = 0; i < count; i++) {
+      const TinyGsmCommandStats& c = table[i];
+      out.print(c.name);
+      out.print(" n=");    out.print(c.count);
+      out.print(" to=");   out.print(c.timeouts);
+      out.print(" err=");  out.print(c.errors);
+      out.print(" min=");  out.print(c.count ? c.min : 0);
+      out.print(" avg=");  out.print(c.avg());
+      out.print(" max=");  out.print(c.max);
+      out.print(" p99=");  out.println(c.percentile(99));
+    }
+    for (uint8_t mux = 0; mux < TINY_GSM_MUX_COUNT; mux++) {
+      if (!tx[mux] && !rx[mux]) continue;
+      out.print("mux ");   out.print(mux);
+      out.print(" tx=");   out.print(tx[mux]);
+      out.print(" rx=");   out.println(rx[mux]);
+    }
+  }
+
+  /*
+   * Hooks for the drivers
+   */
+
+  // sendAT(): the first argument names the command
+  template<typename T, typename... Args>
+  void sent(T cmd, Args...) {
+    char name[TINY_GSM_STATS_NAME + 1];
+    uint8_t n = 0;
+    for (char c; n < TINY_GSM_STATS_NAME && (c = charAt(cmd, n)) && c != '=' && c != '?'; n++) {
+      name[n] = c;
+    }
+    name[n] = '\0';
+    start(n ? name : "AT");
+  }
+
+  void sent() {
+    start("AT");
+  }
+
+  // waitResponse(): only the first one after sendAT() counts
+  void received(uint8_t index, bool error) {
+    TinyGsmCommandStats* c = current;
+    if (!c) return;
+    current = NULL;
+    if (!index) {
+      c->timeouts++;
+      return;
+    }
+    uint32_t ms = millis() - started;
+    c->count++;
+    c->errors += error;
+    c->total += ms;
+    if (c->count == 1 || ms < c->min) c->min = ms;
+    if (ms > c->max) c->max = ms;
+    uint8_t b = 0;
+    for (uint32_t v = ms; v && b < TINY_GSM_STATS_BUCKETS - 1; v >>= 1) b++;
+    if (c->hist[b] == 0xFFFF) {
+      // Halving keeps the shape of the histogram
+      for (uint8_t i = 0; i < TINY_GSM_STATS_BUCKETS; i++) c->hist[i] >>= 1;
+    }
+    c->hist[b]++;
+  }
+
+  void sentData(uint8_t mux, size_t len) {
+    if (mux < TINY_GSM_MUX_COUNT) tx[mux] += len;
+  }
+
+  void receivedData(uint8_t mux, size_t len) {
+    if (mux < TINY_GSM_MUX_COUNT) rx[mux] += len;
+  }
+
+private:
+  static char charAt(GsmConstStr s, uint8_t i) { return TinyGsmStrChar(s, i); }
+#if defined(__AVR__)
+  static char charAt(const char* s, uint8_t i) { return s[i]; }
+#endif
+
+  void start(const char* name) {
+    started = millis();
+    current = NULL;
+    for (uint8_t i = 0; i < count; i++) {
+      if (!strcmp(table[i].name, name)) {
+        current = &table[i];
+        return;
+      }
+    }
+    if (count < TINY_GSM_STATS_COMMANDS) {
+      current = &table[count++];
+      memset(current, 0, sizeof(*current));
+      strcpy(current->name, name);
+    }
+  }
+
+  TinyGsmCommandStats  table[TINY_GSM_STATS_COMMANDS];
+  uint8_t              count;
+  TinyGsmCommandStats* current;
+  uint32_t             started;
+  uint32_t             tx[TINY_GSM_MUX_COUNT];
+  uint32_t             rx[TINY_GSM_MUX_COUNT];
+};
+
+#endif // TINY_GSM_STATS
+
 template<class T>
 uint32_t TinyGsmAutoBaud(T& SerialAT, uint32_t minimum = 9600, uint32_t maximum = 115200)
 {
@@ -135,7 +859,182 @@ uint32_t TinyGsmAutoBaud(T& SerialAT, uint32_t minimum = 9600, uint32_t maximum
   return 0;
 }
 
+/*
+ * Hex codec.
+ * Digits are decoded through a 256-entry table (in flash on AVR), so there is
+ * no branching or strtol() per byte. Anything that is not a hex digit reads
+ * as 0. On x86 hosts, blocks of 16 digits are decoded with SSE2.
+ */
+#if defined(__SSE2__) && !defined(TINY_GSM_NO_SIMD)
+  #include <emmintrin.h>
+  #define TINY_GSM_HEX_SSE2
+#endif
+
+static const uint8_t TinyGsmHexTable[256] TINY_GSM_PROGMEM = {
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  0,  0,  0,  0,  0,  0,
+   0, 10, 11, 12, 13, 14, 15,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0, 10, 11, 12, 13, 14, 15,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+};
+
+static inline
+uint8_t TinyGsmHexValue(char c) {
+#if defined(__AVR__)
+  return pgm_read_byte(TinyGsmHexTable + (uint8_t)c);
+#else
+  return TinyGsmHexTable[(uint8_t)c];
+#endif
+}
+
+#if defined(TINY_GSM_HEX_SSE2)
+// 0xFF in each byte of x that lies in lo..hi (unsigned), 0 elsewhere
+static inline
+__m128i TinyGsmHexRange(__m128i x, char lo, char hi) {
+  return _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8(lo)), x),
+                       _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(hi)), x));
+}
+#endif
+
+// Decodes n bytes from 2*n hex digits; dst may be the same buffer as src
+static inline
+void TinyGsmHexDecode(uint8_t* dst, const char* src, size_t n) {
+  size_t i = 0;
+#if defined(TINY_GSM_HEX_SSE2)
+  const __m128i zero  = _mm_set1_epi8('0');
+  const __m128i lower = _mm_set1_epi8(0x20);
+  const __m128i alpha = _mm_set1_epi8('a' - 10);
+  const __m128i low   = _mm_set1_epi16(0x00FF);
+  for (; i + 8 <= n; i += 8) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(src + i * 2));
+    __m128i l = _mm_or_si128(x, lower);
+    // Same as the table: anything but 0-9, A-F, a-f reads as 0
+    __m128i v = _mm_or_si128(
+        _mm_and_si128(TinyGsmHexRange(x, '0', '9'), _mm_sub_epi8(x, zero)),
+        _mm_and_si128(TinyGsmHexRange(l, 'a', 'f'), _mm_sub_epi8(l, alpha)));
+    // Each 16-bit lane holds the high digit in its low byte
+    __m128i b = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, low), 4),
+                             _mm_srli_epi16(v, 8));
+    _mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(b, b));
+  }
+#endif
+  for (src += i * 2; i < n; i++, src += 2) {
+    dst[i] = (TinyGsmHexValue(src[0]) << 4) | TinyGsmHexValue(src[1]);
+  }
+}
+
 #ifndef TINY_GSM_NO_GPRS
+
+#if !defined(TINY_GSM_TX_BUFFER)
+  #define TINY_GSM_TX_BUFFER 64
+#endif
+
+#if !defined(TINY_GSM_TX_IDLE)
+  #define TINY_GSM_TX_IDLE 20
+#endif
+
+/*
+ * Transmit side of a GsmClient.
+ * Small writes (Print sends a println() or a single char separately) are
+ * collected here, so a request line costs one send command instead of one
+ * per write(). The client sends the buffer when the next write does not
+ * fit, on flush(), before reading or closing, and from maintain() once no
+ * write came for TINY_GSM_TX_IDLE ms.
+ * write() reports collected bytes as written, so if sending them fails
+ * later (or the socket closed meanwhile) the client sets its write error:
+ * getWriteError() is non-zero and write() returns 0 until the next connect.
+ * On a socket that is not connected, write() returns 0 right away.
+ */
+class TinyGsmTxBuffer
+{
+public:
+  TinyGsmTxBuffer() : len(0), stamp(0) {}
+
+  void clear() { len = 0; }
+
+  // Returns false, and keeps nothing, if data does not fit
+  bool append(const uint8_t* data, size_t size) {
+    if (size > (size_t)(TINY_GSM_TX_BUFFER - len)) return false;
+    memcpy(buf + len, data, size);
+    len += size;
+    stamp = millis();
+    return true;
+  }
+
+  bool idle() const { return len && millis() - stamp >= TINY_GSM_TX_IDLE; }
+
+  size_t size() const { return len; }
+  const uint8_t* data() const { return buf; }
+
+private:
+  uint8_t   buf[TINY_GSM_TX_BUFFER];
+  uint16_t  len;
+  uint32_t  stamp;
+};
+
+#if !defined(TINY_GSM_READ_CHUNK)
+  #define TINY_GSM_READ_CHUNK 64
+#endif
+
+/*
+ * Receives a socket payload of len bytes (2*len hex digits if hex is set).
+ * The first size bytes go to buf, if given, and the rest straight into the
+ * free span of rx; what does not fit in rx is dropped.
+ * Data is moved in blocks with readBytes(), so a stall is bounded by the
+ * stream timeout; returns the number of bytes actually received.
+ */
+template<class Fifo>
+size_t TinyGsmReadPayload(Stream& stream, Fifo& rx, size_t len,
+                          uint8_t* buf = NULL, size_t size = 0, bool hex = false)
+{
+  uint8_t chunk[TINY_GSM_READ_CHUNK];
+  size_t done = 0;
+  while (done < len) {
+    size_t n = len - done;
+    uint8_t* dst;
+    size_t room;
+    bool fifo = false;
+    if (buf && done < size) {
+      dst = buf + done;
+      room = size - done;
+    } else if ((room = rx.reserve(dst)) > 0) {
+      fifo = true;
+    } else {
+      dst = chunk;
+      room = sizeof(chunk);
+    }
+    n = TinyGsmMin(n, room);
+    size_t got;
+    if (hex) {
+      n = TinyGsmMin(n, sizeof(chunk) / 2);
+      size_t digits = stream.readBytes((char*)chunk, n * 2);
+      // A read that stopped between the two digits of a byte gets the other one
+      if (digits & 1) {
+        digits += stream.readBytes((char*)chunk + digits, 1);
+      }
+      got = digits / 2;
+      TinyGsmHexDecode(dst, (const char*)chunk, got);
+    } else {
+      got = stream.readBytes((char*)dst, n);
+    }
+    if (fifo) rx.commit(got);
+    done += got;
+    if (got < n) break;
+  }
+  return done;
+}
+
 static inline
 IPAddress TinyGsmIpFromString(const String& strIP) {
   int Parts[4] = {0, };
@@ -157,6 +1056,108 @@ IPAddress TinyGsmIpFromString(const String& strIP) {
   }
   return IPAddress(Parts[0], Parts[1], Parts[2], Parts[3]);
 }
+
+static inline
+String TinyGsmIpToString(const IPAddress& ip) {
+  String host;
+  host.reserve(16);
+  host += ip[0];
+  host += ".";
+  host += ip[1];
+  host += ".";
+  host += ip[2];
+  host += ".";
+  host += ip[3];
+  return host;
+}
+
+#if !defined(TINY_GSM_DNS_CACHE)
+  #if defined(__AVR__)
+    #define TINY_GSM_DNS_CACHE 2
+  #else
+    #define TINY_GSM_DNS_CACHE 4
+  #endif
+#endif
+
+// Longest host name the cache keeps
+#if !defined(TINY_GSM_DNS_HOST)
+  #define TINY_GSM_DNS_HOST 40
+#endif
+
+// The modems do not report the record TTL, so entries expire after this (ms)
+#if !defined(TINY_GSM_DNS_TTL)
+  #define TINY_GSM_DNS_TTL 3600000L
+#endif
+
+/*
+ * Host name -> IP address, so repeated connects to the same hosts skip
+ * the lookup. When full, the entry that expires first is replaced.
+ */
+class TinyGsmDnsCache
+{
+public:
+  TinyGsmDnsCache() {
+    clear();
+  }
+
+  // True if a fresh entry for host exists, its address goes to ip
+  bool lookup(const char* host, IPAddress& ip) {
+    Entry* e = find(host);
+    if (!e) return false;
+    if (millis() - e->stored > TINY_GSM_DNS_TTL) {
+      e->host[0] = '\0';
+      return false;
+    }
+    ip = IPAddress(e->ip[0], e->ip[1], e->ip[2], e->ip[3]);
+    return true;
+  }
+
+  void store(const char* host, const IPAddress& ip) {
+    if (strlen(host) >= TINY_GSM_DNS_HOST || !ip[0]) return;
+    Entry* e = find(host);
+    if (!e) {
+      e = &entries[0];
+      for (uint8_t i = 0; i < TINY_GSM_DNS_CACHE; i++) {
+        if (!entries[i].host[0]) {
+          e = &entries[i];
+          break;
+        }
+        if ((int32_t)(entries[i].stored - e->stored) < 0) e = &entries[i];
+      }
+      strcpy(e->host, host);
+    }
+    for (uint8_t i = 0; i < 4; i++) e->ip[i] = ip[i];
+    e->stored = millis();
+  }
+
+  // Drops host, e.g. after a connect to its cached address failed
+  void remove(const char* host) {
+    Entry* e = find(host);
+    if (e) e->host[0] = '\0';
+  }
+
+  void clear() {
+    for (uint8_t i = 0; i < TINY_GSM_DNS_CACHE; i++) {
+      entries[i].host[0] = '\0';
+    }
+  }
+
+private:
+  struct Entry {
+    char     host[TINY_GSM_DNS_HOST];
+    uint8_t  ip[4];
+    uint32_t stored;
+  };
+
+  Entry* find(const char* host) {
+    for (uint8_t i = 0; i < TINY_GSM_DNS_CACHE; i++) {
+      if (entries[i].host[0] && !strcmp(entries[i].host, host)) return &entries[i];
+    }
+    return NULL;
+  }
+
+  Entry entries[TINY_GSM_DNS_CACHE];
+};
 #endif // TINY_GSM_NO_GPRS
 static inline
 String TinyGsmDecodeHex7bit(const String &instr) {
@@ -164,10 +1165,7 @@ String TinyGsmDecodeHex7bit(const String &instr) {
   byte reminder = 0;
   int bitstate = 7;
   for (unsigned i=0; i<instr.length(); i+=2) {
-    char buf[4] = { 0, };
-    buf[0] = instr[i];
-    buf[1] = instr[i+1];
-    byte b = strtol(buf, NULL, 16);
+    byte b = (TinyGsmHexValue(instr[i]) << 4) | TinyGsmHexValue(instr[i+1]);
 
     byte bb = b << (7 - bitstate);
     char c = (bb + reminder) & 0x7F;
@@ -184,41 +1182,77 @@ String TinyGsmDecodeHex7bit(const String &instr) {
   return result;
 }
 
+// Decodes 8-bit hex text into out (NUL-terminated), returns the length
+static inline
+size_t TinyGsmDecodeHex8bit(const char* instr, size_t len, char* out, size_t size) {
+  if (!size) return 0;
+  size_t n = TinyGsmMin(len / 2, size - 1);
+  TinyGsmHexDecode((uint8_t*)out, instr, n);
+  out[n] = '\0';
+  return n;
+}
+
 static inline
 String TinyGsmDecodeHex8bit(const String &instr) {
   String result;
-  for (unsigned i=0; i<instr.length(); i+=2) {
-    char buf[4] = { 0, };
-    buf[0] = instr[i];
-    buf[1] = instr[i+1];
-    char b = strtol(buf, NULL, 16);
-    result += b;
+  char buf[32];
+  const char* p = instr.c_str();
+  size_t left = instr.length() / 2;
+  result.reserve(left);
+  while (left) {
+    size_t n = TinyGsmMin(left, sizeof(buf) - 1);
+    TinyGsmDecodeHex8bit(p, n * 2, buf, sizeof(buf));
+    for (size_t i = 0; i < n; i++) result += buf[i];
+    p += n * 2;
+    left -= n;
   }
   return result;
 }
 
+// Decodes UCS2 hex text into out (NUL-terminated), returns the length.
+// Characters outside Latin-1 become "?" (or "\xHHHH" with TINY_GSM_UNICODE_TO_HEX)
 static inline
-String TinyGsmDecodeHex16bit(const String &instr) {
-  String result;
-  for (unsigned i=0; i<instr.length(); i+=4) {
-    char buf[4] = { 0, };
-    buf[0] = instr[i];
-    buf[1] = instr[i+1];
-    char b = strtol(buf, NULL, 16);
-    if (b) { // If high byte is non-zero, we can't handle it ;(
+size_t TinyGsmDecodeHex16bit(const char* instr, size_t len, char* out, size_t size) {
+  if (!size) return 0;
+  size_t n = 0;
+  for (size_t i = 0; i + 4 <= len; i += 4) {
+    uint8_t b[2];
+    TinyGsmHexDecode(b, instr + i, 2);
+    if (b[0]) { // If high byte is non-zero, we can't handle it ;(
 #if defined(TINY_GSM_UNICODE_TO_HEX)
-      result += "\\x";
-      result += instr.substring(i, i+4);
+      if (n + 6 >= size) break;
+      out[n++] = '\\';
+      out[n++] = 'x';
+      memcpy(out + n, instr + i, 4);
+      n += 4;
 #else
-      result += "?";
+      if (n + 1 >= size) break;
+      out[n++] = '?';
 #endif
     } else {
-      buf[0] = instr[i+2];
-      buf[1] = instr[i+3];
-      b = strtol(buf, NULL, 16);
-      result += b;
+      if (n + 1 >= size) break;
+      out[n++] = b[1];
     }
   }
+  out[n] = '\0';
+  return n;
+}
+
+static inline
+String TinyGsmDecodeHex16bit(const String &instr) {
+  String result;
+  char buf[32];
+  const char* p = instr.c_str();
+  size_t left = instr.length() / 4 * 4;
+  result.reserve(left / 4);
+  while (left) {
+    // 20 digits decode to at most 5 "\xHHHH" escapes, which fit the buffer
+    size_t chunk = TinyGsmMin(left, (size_t)20);
+    size_t n = TinyGsmDecodeHex16bit(p, chunk, buf, sizeof(buf));
+    for (size_t i = 0; i < n; i++) result += buf[i];
+    p += chunk;
+    left -= chunk;
+  }
   return result;
 }
 
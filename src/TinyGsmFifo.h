@@ -1,7 +1,20 @@
 #ifndef TinyGsmFifo_h
 #define TinyGsmFifo_h
 
-template <class T, unsigned N>
+#if defined(__AVR__)
+  #include <util/atomic.h>
+#else
+  #include <atomic>
+#endif
+
+/*
+ * Ring buffer used under every socket.
+ * Besides put()/get(), both sides can work on the buffer in place:
+ * reserve() and peek() return the largest contiguous writable or readable
+ * span, which stops at the end of the buffer; commit() and consume() then
+ * account for what was actually written or read.
+ */
+template <class T, unsigned N, bool Pow2 = ((N & (N - 1)) == 0)>
 class TinyGsmFifo
 {
 public:
@@ -69,6 +82,22 @@ public:
         return n - c;
     }
 
+    int reserve(T*& p)
+    {
+        int w = _w;
+        int r = _r;
+        p = &_b[w];
+        if (r > w)
+            return r - w - 1;
+        // The last slot stays empty if r is 0
+        return N - w - (r == 0 ? 1 : 0);
+    }
+
+    void commit(int n)
+    {
+        _w = _inc(_w, n);
+    }
+
     // reading thread/context API
     // --------------------------------------------------------
 
@@ -122,6 +151,19 @@ public:
         return n - c;
     }
 
+    int peek(const T*& p)
+    {
+        int r = _r;
+        int w = _w;
+        p = &_b[r];
+        return (w >= r) ? w - r : N - r;
+    }
+
+    void consume(int n)
+    {
+        _r = _inc(_r, n);
+    }
+
 private:
     int _inc(int i, int n = 1)
     {
@@ -133,4 +175,348 @@ private:
     int  _r;
 };
 
+/*
+ * Specialization for a power-of-two N (all default buffer sizes are).
+ * The indices run freely and are masked on access, so there is no division
+ * and no wraparound fixup, and all N slots can be used.
+ */
+template <class T, unsigned N>
+class TinyGsmFifo<T, N, true>
+{
+public:
+    TinyGsmFifo()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        _r = 0;
+        _w = 0;
+    }
+
+    // writing thread/context API
+    //-------------------------------------------------------------
+
+    bool writeable(void)
+    {
+        return free() > 0;
+    }
+
+    int free(void)
+    {
+        return N - (unsigned)(_w - _r);
+    }
+
+    bool put(const T& c)
+    {
+        if ((unsigned)(_w - _r) == N) // !writeable()
+            return false;
+        _b[_w & M] = c;
+        _w++;
+        return true;
+    }
+
+    int put(const T* p, int n, bool t = false)
+    {
+        int c = n;
+        while (c)
+        {
+            T* d;
+            int f;
+            while ((f = reserve(d)) == 0) // wait for space
+            {
+                if (!t) return n - c; // no more space and not blocking
+                /* nothing / just wait */;
+            }
+            if (c < f) f = c;
+            memcpy(d, p, f * sizeof(T));
+            commit(f);
+            c -= f;
+            p += f;
+        }
+        return n - c;
+    }
+
+    int reserve(T*& p)
+    {
+        unsigned w = _w & M;
+        int f = free();
+        p = &_b[w];
+        return ((unsigned)f < N - w) ? f : N - w;
+    }
+
+    void commit(int n)
+    {
+        _w += n;
+    }
+
+    // reading thread/context API
+    // --------------------------------------------------------
+
+    bool readable(void)
+    {
+        return (_r != _w);
+    }
+
+    size_t size(void)
+    {
+        return (unsigned)(_w - _r);
+    }
+
+    bool get(T* p)
+    {
+        if (_r == _w) // !readable()
+            return false;
+        *p = _b[_r & M];
+        _r++;
+        return true;
+    }
+
+    int get(T* p, int n, bool t = false)
+    {
+        int c = n;
+        while (c)
+        {
+            const T* s;
+            int f;
+            while ((f = peek(s)) == 0) // wait for data
+            {
+                if (!t) return n - c; // no data and not blocking
+                /* nothing / just wait */;
+            }
+            if (c < f) f = c;
+            memcpy(p, s, f * sizeof(T));
+            consume(f);
+            c -= f;
+            p += f;
+        }
+        return n - c;
+    }
+
+    int peek(const T*& p)
+    {
+        unsigned r = _r & M;
+        unsigned s = _w - _r;
+        p = &_b[r];
+        return (s < N - r) ? s : N - r;
+    }
+
+    void consume(int n)
+    {
+        _r += n;
+    }
+
+private:
+    enum { M = N - 1 };
+
+    T         _b[N];
+    unsigned  _w;
+    unsigned  _r;
+};
+
+// Index shared between the producer and the consumer of TinyGsmSpscFifo
+#if defined(__AVR__)
+class TinyGsmFifoIndex
+{
+public:
+    // AVR has no <atomic>: a 16-bit access is two instructions, so it is
+    // done with interrupts off; ATOMIC_BLOCK is also a compiler barrier
+    int load() const
+    {
+        int v;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { v = _v; }
+        return v;
+    }
+    int loadOwn() const { return load(); }
+    void store(int v)
+    {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { _v = v; }
+    }
+
+private:
+    volatile int _v;
+};
+#else
+class TinyGsmFifoIndex
+{
+public:
+    // Acquire pairs with the other side's release store, so the slots it
+    // filled (or freed) are visible before the index that publishes them
+    int load() const { return _v.load(std::memory_order_acquire); }
+    // Only the owning side writes this index, so it may read it relaxed
+    int loadOwn() const { return _v.load(std::memory_order_relaxed); }
+    void store(int v) { _v.store(v, std::memory_order_release); }
+
+private:
+    std::atomic<int> _v;
+};
+#endif
+
+/*
+ * Single-producer/single-consumer variant of TinyGsmFifo.
+ * One context (e.g. a UART ISR or the other core) may call the writing API
+ * while another calls the reading API, without locks. Each side only stores
+ * its own index. One slot is kept empty, so it holds up to N-1 elements.
+ *
+ * Besides copying put()/get(), both sides can work on the buffer in place:
+ *
+ *   T* p;                                  const T* p;
+ *   int n = fifo.reserve(p);               int n = fifo.peek(p);
+ *   n = uart_read(p, n);                   n = parse(p, n);
+ *   fifo.commit(n);                        fifo.consume(n);
+ *
+ * Spans are contiguous, so they stop at the end of the buffer; call again
+ * for the part after the wrap.
+ */
+template <class T, unsigned N>
+class TinyGsmSpscFifo
+{
+public:
+    TinyGsmSpscFifo()
+    {
+        clear();
+    }
+
+    // Only safe while neither side is active
+    void clear()
+    {
+        _r.store(0);
+        _w.store(0);
+    }
+
+    // writing thread/context API
+    //-------------------------------------------------------------
+
+    bool writeable(void)
+    {
+        return free() > 0;
+    }
+
+    int free(void)
+    {
+        int s = _r.load() - _w.loadOwn();
+        if (s <= 0)
+            s += N;
+        return s - 1;
+    }
+
+    // Contiguous free span starting at the write position
+    int reserve(T*& p)
+    {
+        int w = _w.loadOwn();
+        int r = _r.load();
+        p = &_b[w];
+        if (r > w)
+            return r - w - 1;
+        // Up to the end of the buffer; the last slot stays empty if r is 0
+        return N - w - (r == 0 ? 1 : 0);
+    }
+
+    // Publishes n elements written into the span from reserve()
+    void commit(int n)
+    {
+        _w.store(_inc(_w.loadOwn(), n));
+    }
+
+    bool put(const T& c)
+    {
+        T* p;
+        if (reserve(p) == 0)
+            return false;
+        *p = c;
+        commit(1);
+        return true;
+    }
+
+    // Non-blocking; returns the number of elements stored
+    int put(const T* p, int n)
+    {
+        int c = n;
+        while (c)
+        {
+            T* d;
+            int f = reserve(d);
+            if (f == 0)
+                break;
+            if (c < f) f = c;
+            memcpy(d, p, f * sizeof(T));
+            commit(f);
+            c -= f;
+            p += f;
+        }
+        return n - c;
+    }
+
+    // reading thread/context API
+    // --------------------------------------------------------
+
+    bool readable(void)
+    {
+        return _r.loadOwn() != _w.load();
+    }
+
+    size_t size(void)
+    {
+        int s = _w.load() - _r.loadOwn();
+        if (s < 0)
+            s += N;
+        return s;
+    }
+
+    // Contiguous readable span starting at the read position
+    int peek(const T*& p)
+    {
+        int r = _r.loadOwn();
+        int w = _w.load();
+        p = &_b[r];
+        return (w >= r) ? w - r : N - r;
+    }
+
+    // Releases n elements of the span from peek() to the producer
+    void consume(int n)
+    {
+        _r.store(_inc(_r.loadOwn(), n));
+    }
+
+    bool get(T* p)
+    {
+        const T* s;
+        if (peek(s) == 0)
+            return false;
+        *p = *s;
+        consume(1);
+        return true;
+    }
+
+    // Non-blocking; returns the number of elements read
+    int get(T* p, int n)
+    {
+        int c = n;
+        while (c)
+        {
+            const T* s;
+            int f = peek(s);
+            if (f == 0)
+                break;
+            if (c < f) f = c;
+            memcpy(p, s, f * sizeof(T));
+            consume(f);
+            c -= f;
+            p += f;
+        }
+        return n - c;
+    }
+
+private:
+    int _inc(int i, int n = 1)
+    {
+        return (i + n) % N;
+    }
+
+    T                _b[N];
+    TinyGsmFifoIndex _w;
+    TinyGsmFifoIndex _r;
+};
+
 #endif
@@ -0,0 +1,162 @@
+/**
+ * @file       TinyGsmPool.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Pool of modem sockets that picks the mux itself and keeps connections
+ * open between requests.
+ *
+ *   TinyGsmPool<TinyGsm> pool(modem);
+ *
+ *   TinyGsmClient* client = pool.acquire("example.com", 80);
+ *   if (client) {
+ *     ...                    // One request
+ *     pool.release(client);  // Stays open for the next acquire() of example.com:80
+ *   }
+ *   pool.maintain();         // Closes connections that were idle for too long
+ *
+ * Use TinyGsmPool<TinyGsm, TinyGsmClientSecure> to keep TLS sessions, so
+ * a reused connection also saves the handshake.
+ * The pool owns the sockets from mux first on; don't create other clients
+ * on those. Modems that pick the mux on connect (A6) are not supported.
+ */
+
+#ifndef TinyGsmPool_h
+#define TinyGsmPool_h
+
+#include <TinyGsmCommon.h>
+
+// Connections held by a pool at most
+#if !defined(TINY_GSM_POOL_SIZE)
+  #define TINY_GSM_POOL_SIZE 4
+#endif
+
+// An idle connection is closed after this many ms
+#if !defined(TINY_GSM_POOL_IDLE)
+  #define TINY_GSM_POOL_IDLE 60000L
+#endif
+
+// Longest host name that is remembered for reuse
+#if !defined(TINY_GSM_POOL_HOST)
+  #define TINY_GSM_POOL_HOST 48
+#endif
+
+template<class Modem, class Sock = typename Modem::GsmClient>
+class TinyGsmPool
+{
+public:
+  explicit TinyGsmPool(Modem& modem, uint8_t first = 0)
+    : count(0)
+  {
+    for (uint8_t i = 0; i < TINY_GSM_POOL_SIZE && first + i < TINY_GSM_MUX_COUNT; i++) {
+      Slot& s = slots[i];
+      s.client.init(&modem, first + i);
+      s.host[0] = '\0';
+      s.port = 0;
+      s.busy = false;
+      s.last = 0;
+      count++;
+    }
+  }
+
+  // Returns a client connected to host:port, or NULL if none could be set up.
+  // An idle connection to the same endpoint is handed out as it is; otherwise
+  // a free socket is used, or the one idle for the longest time is closed.
+  // A connection whose write failed is not reused
+  Sock* acquire(const char* host, uint16_t port) {
+    Slot* pick = NULL;
+    for (uint8_t i = 0; i < count; i++) {
+      Slot& s = slots[i];
+      if (s.busy) continue;
+      if (s.host[0] && s.port == port && !strcmp(s.host, host)) {
+        if (s.client.connected() && !s.client.getWriteError()) {
+          DBG("### Pool reuse:", host, port);
+          s.busy = true;
+          return &s.client;
+        }
+        s.host[0] = '\0'; // Closed by the remote end meanwhile, or broken
+      }
+      if (!s.host[0]) {
+        if (!pick || pick->host[0]) pick = &s;
+      } else if (!pick || (pick->host[0] && (int32_t)(s.last - pick->last) < 0)) {
+        pick = &s; // Idle for longer than the previous pick
+      }
+    }
+    if (!pick) {
+      return NULL;
+    }
+    pick->host[0] = '\0';
+    pick->client.clearWriteError(); // Not every driver does it on connect
+    if (!pick->client.connect(host, port)) {
+      return NULL;
+    }
+    // Too long a name is still connected, just not kept for reuse
+    if (strlen(host) < sizeof(pick->host)) {
+      strcpy(pick->host, host);
+      pick->port = port;
+    }
+    pick->busy = true;
+    return &pick->client;
+  }
+
+  // Hands a client back. It stays open for reuse, unless close is set,
+  // a write failed, or unread data is left that the next user would get
+  void release(Sock* client, bool close = false) {
+    Slot* s = find(client);
+    if (!s) return;
+    if (close || !s->host[0] || s->client.getWriteError() ||
+        s->client.available() > 0) {
+      s->client.stop();
+      s->host[0] = '\0';
+    }
+    s->busy = false;
+    s->last = millis();
+  }
+
+  // Closes connections idle for more than TINY_GSM_POOL_IDLE ms
+  void maintain() {
+    for (uint8_t i = 0; i < count; i++) {
+      Slot& s = slots[i];
+      if (!s.busy && s.host[0] && millis() - s.last > TINY_GSM_POOL_IDLE) {
+        s.client.stop();
+        s.host[0] = '\0';
+      }
+    }
+  }
+
+  // Closes all idle connections
+  void closeIdle() {
+    for (uint8_t i = 0; i < count; i++) {
+      Slot& s = slots[i];
+      if (!s.busy && s.host[0]) {
+        s.client.stop();
+        s.host[0] = '\0';
+      }
+    }
+  }
+
+  uint8_t size() const { return count; }
+
+private:
+  struct Slot {
+    Sock     client;
+    char     host[TINY_GSM_POOL_HOST];
+    uint16_t port;
+    bool     busy;
+    uint32_t last;
+  };
+
+  Slot* find(Sock* client) {
+    for (uint8_t i = 0; i < count; i++) {
+      if (&slots[i].client == client) return &slots[i];
+    }
+    return NULL;
+  }
+
+  Slot    slots[TINY_GSM_POOL_SIZE];
+  uint8_t count;
+};
+
+#endif
@@ -0,0 +1,395 @@
+/**
+ * @file       TinyGsmTask.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Runs a modem in a task of its own, for multitasking targets.
+ *
+ * The drivers are not reentrant, so a single task owns the modem and its
+ * GsmClients. Other tasks use TinyGsmProxyClient, a Client whose read() and
+ * write() only touch lock-free buffers; the modem task moves the data
+ * between those buffers and the real sockets. Modem functions are run in
+ * the modem task through TinyGsmTask::call().
+ *
+ *   TinyGsm modem(SerialAT);
+ *   TinyGsmTask<TinyGsm> task(modem);
+ *   TinyGsmProxyClient client;
+ *
+ *   task.attach(client, 1);   // Socket 1 of the modem
+ *   task.begin();             // From here on, only the task uses modem
+ *   client.connect("example.com", 80);
+ *
+ * Each proxy must be used by one task at a time.
+ * Supported on ESP32 (FreeRTOS) and in the host build (std::thread).
+ */
+
+#ifndef TinyGsmTask_h
+#define TinyGsmTask_h
+
+#include <TinyGsmCommon.h>
+
+#if defined(ESP32)
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+  #include <freertos/semphr.h>
+  // Lets other tasks run while waiting for the modem task
+  #define TINY_GSM_TASK_WAIT() vTaskDelay(1)
+#elif defined(TINY_GSM_HOST)
+  #include <thread>
+  #include <mutex>
+  #define TINY_GSM_TASK_WAIT() std::this_thread::yield()
+#else
+  #error "TinyGsmTask needs FreeRTOS (ESP32) or the host build"
+#endif
+
+#if !defined(TINY_GSM_PROXY_BUFFER)
+  #define TINY_GSM_PROXY_BUFFER 1024
+#endif
+
+#if !defined(TINY_GSM_TASK_CLIENTS)
+  #define TINY_GSM_TASK_CLIENTS 4
+#endif
+
+/*
+ * Client side of a socket owned by a TinyGsmTask.
+ * connect(), stop() and flush() block the calling task until the modem
+ * task has done the work, and fail at once while it is not running;
+ * read() and write() only wait if the buffer is empty or full.
+ * Once the modem could not send, write() returns a short count and
+ * getWriteError() is set until the next connect().
+ */
+class TinyGsmProxyClient : public Client
+{
+  template<class Modem> friend class TinyGsmTask;
+
+public:
+  TinyGsmProxyClient()
+    : attached(NULL), port(0)
+  {
+    host[0] = '\0';
+    request.store(REQ_NONE);
+    state.store(STATE_CLOSED);
+  }
+
+  virtual int connect(const char* host, uint16_t port) {
+    if (!attached || strlen(host) >= sizeof(this->host)) return 0;
+    strcpy(this->host, host);
+    this->port = port;
+    clearWriteError();
+    return transact(REQ_CONNECT) == STATE_CONNECTED;
+  }
+
+  virtual int connect(IPAddress ip, uint16_t port) {
+    return connect(TinyGsmIpToString(ip).c_str(), port);
+  }
+
+  virtual void stop() {
+    if (attached) transact(REQ_STOP);
+  }
+
+  virtual size_t write(const uint8_t* buf, size_t size) {
+    size_t sent = 0;
+    while (sent < size) {
+      if (state.load() != STATE_CONNECTED || !attached->load()) {
+        setWriteError();
+        break;
+      }
+      sent += tx.put(buf + sent, size - sent);
+      if (sent < size) {
+        TINY_GSM_TASK_WAIT();
+      }
+    }
+    return sent;
+  }
+
+  virtual size_t write(uint8_t c) {
+    return write(&c, 1);
+  }
+
+  virtual int available() {
+    int n = rx.size();
+    if (!n) TINY_GSM_YIELD(); // Give the modem task a turn
+    return n;
+  }
+
+  virtual int read(uint8_t* buf, size_t size) {
+    int n = rx.get(buf, size);
+    if (!n) TINY_GSM_YIELD();
+    return n;
+  }
+
+  virtual int read() {
+    uint8_t c;
+    return rx.get(&c) ? c : -1;
+  }
+
+  virtual int peek() {
+    const uint8_t* p;
+    return (rx.peek(p) > 0) ? *p : -1;
+  }
+
+  // Waits until the modem task has passed on everything written
+  virtual void flush() {
+    if (attached) transact(REQ_FLUSH);
+  }
+
+  virtual uint8_t connected() {
+    return rx.size() || state.load() != STATE_CLOSED;
+  }
+
+  virtual operator bool() { return connected(); }
+
+private:
+  enum {
+    REQ_NONE,
+    REQ_CONNECT,
+    REQ_STOP,
+    REQ_FLUSH,
+  };
+
+  enum {
+    STATE_CLOSED,
+    STATE_CONNECTED,
+    STATE_WRITE_FAILED,  // Still open for reading
+  };
+
+  // Hands a request to the modem task and waits until it is done
+  int transact(int req) {
+    if (!attached->load()) return STATE_CLOSED;
+    request.store(req);
+    while (request.load() != REQ_NONE) {
+      if (!attached->load()) {
+        // The task ended before it got to it
+        request.store(REQ_NONE);
+        return STATE_CLOSED;
+      }
+      TINY_GSM_TASK_WAIT();
+    }
+    return state.load();
+  }
+
+  typedef TinyGsmSpscFifo<uint8_t, TINY_GSM_PROXY_BUFFER> Buffer;
+
+  Buffer           rx;       // Modem task -> client
+  Buffer           tx;       // Client -> modem task
+  TinyGsmFifoIndex request;  // Set by the client, cleared by the modem task
+  TinyGsmFifoIndex state;    // Set by the modem task
+  const TinyGsmFifoIndex* attached;  // Whether the owning task runs
+  char             host[64];
+  uint16_t         port;
+};
+
+/*
+ * Owns a modem and runs it in a task of its own.
+ * Modem is the driver class, e.g. TinyGsm.
+ */
+template<class Modem>
+class TinyGsmTask
+{
+public:
+  typedef typename Modem::GsmClient ModemClient;
+  typedef void (*Call)(Modem& modem, void* arg);
+
+  explicit TinyGsmTask(Modem& modem)
+    : modem(modem), count(0), call_fn(NULL), call_arg(NULL)
+  {
+    running.store(0);
+    call_pending.store(0);
+#if defined(ESP32)
+    exited.store(1);
+    call_lock = xSemaphoreCreateMutex();
+#endif
+  }
+
+  ~TinyGsmTask() {
+    end();
+  }
+
+  // Binds a proxy to socket mux of the modem; only before begin()
+  bool attach(TinyGsmProxyClient& proxy, uint8_t mux) {
+    if (running.load() || count >= TINY_GSM_TASK_CLIENTS) return false;
+    clients[count].init(&modem, mux);
+    proxies[count] = &proxy;
+    proxy.attached = &running;
+    count++;
+    return true;
+  }
+
+  // Starts the modem task; stack, priority and core only apply to FreeRTOS
+  bool begin(uint32_t stack = 8192, unsigned priority = 5, int core = 1) {
+    if (running.load()) return false;
+    running.store(1);
+#if defined(ESP32)
+    exited.store(0);
+    if (xTaskCreatePinnedToCore(entry, "TinyGSM", stack, this, priority,
+                                NULL, core) != pdPASS)
+    {
+      running.store(0);
+      exited.store(1);
+      return false;
+    }
+#else
+    thread = std::thread(entry, this);
+#endif
+    return true;
+  }
+
+  // Stops the modem task after its current pass
+  void end() {
+    if (!running.load()) return;
+    running.store(0);
+#if defined(ESP32)
+    while (!exited.load()) {
+      TINY_GSM_TASK_WAIT();
+    }
+#else
+    thread.join();
+#endif
+  }
+
+  // Runs fn(modem, arg) in the modem task and returns when it is done.
+  // Any task may call it, calls are served one at a time
+  void call(Call fn, void* arg = NULL) {
+    lock();
+    call_fn = fn;
+    call_arg = arg;
+    call_pending.store(1);
+    while (call_pending.load()) {
+      TINY_GSM_TASK_WAIT();
+    }
+    unlock();
+  }
+
+  // One pass of the modem task, returns true if it had anything to do
+  bool loop() {
+    bool busy = false;
+    for (uint8_t i = 0; i < count; i++) {
+      busy |= service(*proxies[i], clients[i]);
+    }
+    if (call_pending.load()) {
+      call_fn(modem, call_arg);
+      call_pending.store(0);
+      busy = true;
+    }
+    modem.maintain();
+    return busy;
+  }
+
+private:
+  static void entry(void* arg) {
+    TinyGsmTask* task = static_cast<TinyGsmTask*>(arg);
+    while (task->running.load()) {
+      if (!task->loop()) {
+        delay(1);
+      }
+    }
+#if defined(ESP32)
+    task->exited.store(1);
+    vTaskDelete(NULL);
+#endif
+  }
+
+  bool service(TinyGsmProxyClient& proxy, ModemClient& client) {
+    bool busy = false;
+    int req = proxy.request.load();
+    switch (req) {
+    case TinyGsmProxyClient::REQ_CONNECT:
+      // The client waits in connect(), so both buffers are idle
+      proxy.rx.clear();
+      proxy.tx.clear();
+      proxy.state.store(client.connect(proxy.host, proxy.port) ?
+                        TinyGsmProxyClient::STATE_CONNECTED :
+                        TinyGsmProxyClient::STATE_CLOSED);
+      proxy.request.store(TinyGsmProxyClient::REQ_NONE);
+      return true;
+    case TinyGsmProxyClient::REQ_STOP:
+      client.stop();
+      proxy.tx.clear();
+      proxy.state.store(TinyGsmProxyClient::STATE_CLOSED);
+      proxy.request.store(TinyGsmProxyClient::REQ_NONE);
+      return true;
+    default:
+      break;
+    }
+    int state = proxy.state.load();
+    if (state == TinyGsmProxyClient::STATE_CLOSED) {
+      if (req == TinyGsmProxyClient::REQ_FLUSH) {
+        proxy.request.store(TinyGsmProxyClient::REQ_NONE);
+      }
+      return false;
+    }
+
+    // Client -> modem
+    const uint8_t* out;
+    int n;
+    while ((n = proxy.tx.peek(out)) > 0) {
+      size_t sent = 0;
+      if (state == TinyGsmProxyClient::STATE_CONNECTED) {
+        sent = client.write(out, n);
+        if (!sent || client.getWriteError()) {
+          // write() in the client task gives up on this
+          state = TinyGsmProxyClient::STATE_WRITE_FAILED;
+          proxy.state.store(state);
+        }
+      }
+      // Nothing more goes out, what is left is dropped
+      if (state != TinyGsmProxyClient::STATE_CONNECTED) sent = n;
+      proxy.tx.consume(sent);
+      busy = true;
+      if (sent < (size_t)n) break;
+    }
+    if (req == TinyGsmProxyClient::REQ_FLUSH) {
+      client.flush();
+      proxy.request.store(TinyGsmProxyClient::REQ_NONE);
+    }
+
+    // Modem -> client
+    uint8_t* in;
+    while ((n = proxy.rx.reserve(in)) > 0 && client.available() > 0) {
+      int got = client.read(in, n);
+      if (got <= 0) break;
+      proxy.rx.commit(got);
+      busy = true;
+    }
+    if (!busy && !client.connected()) {
+      proxy.state.store(TinyGsmProxyClient::STATE_CLOSED);
+    }
+    return busy;
+  }
+
+  void lock() {
+#if defined(ESP32)
+    xSemaphoreTake(call_lock, portMAX_DELAY);
+#else
+    call_lock.lock();
+#endif
+  }
+
+  void unlock() {
+#if defined(ESP32)
+    xSemaphoreGive(call_lock);
+#else
+    call_lock.unlock();
+#endif
+  }
+
+  Modem&              modem;
+  ModemClient         clients[TINY_GSM_TASK_CLIENTS];
+  TinyGsmProxyClient* proxies[TINY_GSM_TASK_CLIENTS];
+  uint8_t             count;
+  TinyGsmFifoIndex    running;
+  TinyGsmFifoIndex    call_pending;
+  Call                call_fn;
+  void*               call_arg;
+#if defined(ESP32)
+  TinyGsmFifoIndex    exited;
+  SemaphoreHandle_t   call_lock;
+#else
+  std::thread         thread;
+  std::mutex          call_lock;
+#endif
+};
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ * @file       TinyGsmTrace.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Records the AT traffic in a RAM ring buffer, for post-mortem analysis.
+ * Unlike StreamDebugger it prints nothing while the modem runs, so the
+ * timing stays as it is:
+ *
+ *   TinyGsmTraceBuffer<2048> traceBuf TINY_GSM_TRACE_NOINIT;
+ *   TinyGsmTrace trace(SerialAT, traceBuf);
+ *   TinyGsm modem(trace);
+ *
+ *   if (trace.restored()) trace.dump(SerialMon);   // What led to the reset
+ *
+ * dump() prints the buffer as hex lines, tools/Host/TraceDecode turns them
+ * back into the AT_Spy view, with timestamps if asked for.
+ * TINY_GSM_TRACE_NOINIT keeps the buffer over a reset where the platform
+ * allows it (AVR, ESP32); after a power cycle it starts empty.
+ *
+ * Format: bytes as they were sent or received, 0xFF escaped as FF 00.
+ * After a pause of TINY_GSM_TRACE_GAP ms or a change of direction comes
+ *   FF 01|02 <ms since the previous mark, 2 x 7 bits>     TX or RX
+ * and every half buffer, or when that does not fit,
+ *   FF 03 <millis(), 4 x 7 bits>                          time sync
+ *   FF 04                                                 restart
+ * Marks only contain bytes below 0x80, so a reader can start anywhere.
+ * A time sync holds the low 28 bits of millis(), so the times it gives
+ * wrap every 2^28 ms (about 74.5 hours).
+ * All bytes of one read or write share a timestamp.
+ */
+
+#ifndef TinyGsmTrace_h
+#define TinyGsmTrace_h
+
+#include <TinyGsmCommon.h>
+
+// A pause in one direction longer than this (ms) starts a new mark
+#if !defined(TINY_GSM_TRACE_GAP)
+  #define TINY_GSM_TRACE_GAP 5
+#endif
+
+#if defined(__AVR__)
+  #define TINY_GSM_TRACE_NOINIT __attribute__((section(".noinit")))
+#elif defined(ESP32)
+  #define TINY_GSM_TRACE_NOINIT __NOINIT_ATTR
+#else
+  #define TINY_GSM_TRACE_NOINIT
+#endif
+
+#define TINY_GSM_TRACE_MAGIC  0x54524331UL  // "TRC1"
+
+#define TINY_GSM_TRACE_ESC    0xFF
+#define TINY_GSM_TRACE_TX     0x01
+#define TINY_GSM_TRACE_RX     0x02
+#define TINY_GSM_TRACE_SYNC   0x03
+#define TINY_GSM_TRACE_BOOT   0x04
+
+// Kept in the buffer, so it survives a reset together with the data
+struct TinyGsmTraceState {
+  uint32_t magic;
+  uint32_t size;
+  uint32_t head;   // Bytes written so far
+  uint32_t sync;   // head at the last time sync
+  uint32_t mark;   // millis() at the last mark
+  uint32_t seen;   // millis() at the last byte
+  uint8_t  dir;
+};
+
+// N must be a power of two
+template<size_t N>
+struct TinyGsmTraceBuffer {
+  TinyGsmTraceState state;
+  uint8_t           data[N];
+};
+
+class TinyGsmTrace : public Stream
+{
+public:
+  template<size_t N>
+  TinyGsmTrace(Stream& stream, TinyGsmTraceBuffer<N>& buf)
+    : stream(stream), st(buf.state), data(buf.data), mask(N - 1)
+  {
+    static_assert(N && !(N & (N - 1)), "Trace buffer size must be a power of two");
+    was = st.magic == TINY_GSM_TRACE_MAGIC && st.size == N;
+    if (!was) {
+      st.size = N;
+      clear();
+      return;
+    }
+    put(TINY_GSM_TRACE_ESC);
+    put(TINY_GSM_TRACE_BOOT);
+    st.dir = 0;
+    st.sync = st.head - N; // millis() restarted, sync before the next mark
+  }
+
+  // True if the buffer still held a trace from before the last reset
+  bool restored() const { return was; }
+
+  void clear() {
+    st.magic = TINY_GSM_TRACE_MAGIC;
+    st.head = 0;
+    st.sync = (uint32_t)0 - st.size;
+    st.mark = st.seen = millis();
+    st.dir = 0;
+  }
+
+  // Bytes of trace held, at most the buffer size
+  uint32_t size() const {
+    return TinyGsmMin(st.head, st.size);
+  }
+
+  // Prints the trace, oldest first, as hex lines for TraceDecode
+  void dump(Print& out) const {
+    static const char hex[] = "0123456789ABCDEF";
+    uint32_t n = size();
+    out.print(GF("#TinyGsmTrace "));
+    out.println(n);
+    for (uint32_t i = 0; i < n; i++) {
+      uint8_t b = data[(st.head - n + i) & mask];
+      out.write(hex[b >> 4]);
+      out.write(hex[b & 0x0F]);
+      if ((i & 31) == 31 || i == n - 1) out.println();
+    }
+    out.println(GF("#end"));
+  }
+
+  /*
+   * Stream
+   */
+
+  virtual int available() {
+    return stream.available();
+  }
+
+  virtual int read() {
+    int c = stream.read();
+    if (c >= 0) {
+      record(TINY_GSM_TRACE_RX, c, millis());
+    }
+    return c;
+  }
+
+  virtual int peek() {
+    return stream.peek();
+  }
+
+  virtual size_t readBytes(char* buffer, size_t length) {
+    // The wrapped stream does the waiting; a setTimeout() through a
+    // Stream& only reached this one
+    stream.setTimeout(_timeout);
+    size_t n = stream.readBytes(buffer, length);
+    uint32_t now = millis();
+    for (size_t i = 0; i < n; i++) {
+      record(TINY_GSM_TRACE_RX, (uint8_t)buffer[i], now);
+    }
+    return n;
+  }
+
+  virtual size_t write(uint8_t c) {
+    record(TINY_GSM_TRACE_TX, c, millis());
+    return stream.write(c);
+  }
+
+  virtual size_t write(const uint8_t* buf, size_t size) {
+    uint32_t now = millis();
+    for (size_t i = 0; i < size; i++) {
+      record(TINY_GSM_TRACE_TX, buf[i], now);
+    }
+    return stream.write(buf, size);
+  }
+
+  virtual void flush() {
+    stream.flush();
+  }
+
+  void setTimeout(unsigned long timeout) {
+    Stream::setTimeout(timeout);
+    stream.setTimeout(timeout);
+  }
+
+  using Print::write;
+  using Stream::readBytes;
+
+private:
+  void put(uint8_t b) {
+    data[st.head++ & mask] = b;
+  }
+
+  void record(uint8_t dir, uint8_t c, uint32_t now) {
+    if (dir != st.dir || now - st.seen > TINY_GSM_TRACE_GAP) {
+      stamp(dir, now);
+    }
+    st.seen = now;
+    put(c);
+    if (c == TINY_GSM_TRACE_ESC) put(0x00);
+  }
+
+  void stamp(uint8_t dir, uint32_t now) {
+    uint32_t delta = now - st.mark;
+    if (delta > 0x3FFF || st.head - st.sync >= st.size / 2) {
+      put(TINY_GSM_TRACE_ESC);
+      put(TINY_GSM_TRACE_SYNC);
+      for (uint8_t i = 0; i < 4; i++) put((now >> (7 * i)) & 0x7F);
+      st.sync = st.head;
+      delta = 0;
+    }
+    put(TINY_GSM_TRACE_ESC);
+    put(dir);
+    put(delta & 0x7F);
+    put(delta >> 7);
+    st.mark = now;
+    st.dir = dir;
+  }
+
+  Stream&            stream;
+  TinyGsmTraceState& st;
+  uint8_t*           data;
+  uint32_t           mask;
+  bool               was;
+};
+
+#endif
@@ -0,0 +1,120 @@
+/**
+ * @file       Arduino.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ */
+
+#include "Arduino.h"
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+#include <poll.h>
+#include <unistd.h>
+
+static const std::chrono::steady_clock::time_point host_start = std::chrono::steady_clock::now();
+
+unsigned long millis()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+           std::chrono::steady_clock::now() - host_start).count();
+}
+
+unsigned long micros()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+           std::chrono::steady_clock::now() - host_start).count();
+}
+
+void delay(unsigned long ms)
+{
+  if (ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  } else {
+    std::this_thread::yield();
+  }
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield()
+{
+  std::this_thread::yield();
+}
+
+static std::atomic<unsigned long> host_news(0);
+
+void* operator new(size_t size)
+{
+  host_news.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  free(p);
+}
+
+unsigned long TinyGsmHostAllocs()
+{
+  return host_news.load(std::memory_order_relaxed) + TinyGsmHostStringAllocs;
+}
+
+HostSerial Serial;
+
+bool HostSerial::fill()
+{
+  if (_peeked >= 0) return true;
+  struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+  if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLIN)) return false;
+  uint8_t c;
+  if (::read(STDIN_FILENO, &c, 1) != 1) return false;
+  _peeked = c;
+  return true;
+}
+
+int HostSerial::available()
+{
+  return fill() ? 1 : 0;
+}
+
+int HostSerial::read()
+{
+  if (!fill()) return -1;
+  int c = _peeked;
+  _peeked = -1;
+  return c;
+}
+
+int HostSerial::peek()
+{
+  return fill() ? _peeked : -1;
+}
+
+size_t HostSerial::write(uint8_t c)
+{
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HostSerial::write(const uint8_t *buf, size_t size)
+{
+  return fwrite(buf, 1, size, stdout);
+}
+
+void HostSerial::flush()
+{
+  fflush(stdout);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file       Arduino.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Minimal Arduino core for building TinyGSM on a Linux host.
+ * Only what the library, examples and tools actually use is provided.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <ctype.h>
+#include <algorithm>
+#include <functional>
+
+#define TINY_GSM_HOST
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define B0  0
+#define B1  1
+#define B00 0
+#define B01 1
+#define B10 2
+#define B11 3
+
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+#define F(string_literal) (string_literal)
+
+using std::min;
+using std::max;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// Heap allocations so far: operator new and String buffer (re)allocations
+unsigned long TinyGsmHostAllocs();
+
+// Sketch entry points, called by HostMain.cpp
+void setup();
+void loop();
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+
+// Console serial port, backed by stdin/stdout
+class HostSerial : public Stream
+{
+public:
+  void begin(unsigned long baud) {}
+  void end() {}
+
+  virtual int available();
+  virtual int read();
+  virtual int peek();
+  virtual size_t write(uint8_t c);
+  virtual size_t write(const uint8_t *buf, size_t size);
+  virtual void flush();
+  using Print::write;
+
+  operator bool() { return true; }
+
+private:
+  bool fill();
+
+  int _peeked = -1;
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,576 @@
+/**
+ * @file       Benchmark.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Socket data path benchmark.
+ *
+ * Downloads and uploads the given files through GsmClient::read()/write(),
+ * with FakeModem playing the modem side of the selected driver:
+ *   SIM800   +CIPRXGET (manual read), +CIPSEND
+ *   BG96     +QIRD, +QISEND
+ *   UBLOX    +USORD, +USOWR
+ *   ESP8266  +IPD, +CIPSEND
+ *   A6       +CIPRCV, +CIPSEND
+ *   SIM800T  SIM800 in transparent mode (-DBENCH_TRANSPARENT), raw data
+ *   SIM800P  SIM800 run by TinyGsmTask in a thread (-DBENCH_TASK), the
+ *            benchmark uses a TinyGsmProxyClient
+ *   SIM800H  SIM800 reading hex (-DTINY_GSM_USE_HEX), +CIPRXGET=3
+ *
+ * Build with -DTINY_GSM_MODEM_<name>, run as: bench_<name> file...
+ * The modem answers instantly, so the numbers show library overhead only:
+ *   KB/s       wall clock throughput, including the library's own waits
+ *   cpu us/KB  process CPU time per KB
+ *   AT/KB      AT commands sent per KB
+ *   alloc/KB   heap allocations per KB: operator new and String buffer
+ *              (re)allocations, the harness' own included (kept near zero)
+ *   wire/B     UART bytes (both directions) per payload byte
+ */
+
+#include "FakeModem.h"
+#include <TinyGsmClient.h>
+#if defined(BENCH_TASK)
+#include <TinyGsmTask.h>
+#endif
+
+#include <ctime>
+#include <stdarg.h>
+#include <string>
+#include <vector>
+
+#ifndef BENCH_READ_CHUNK
+#define BENCH_READ_CHUNK 1024
+#endif
+
+#ifndef BENCH_WRITE_CHUNK
+#define BENCH_WRITE_CHUNK 512
+#endif
+
+// Data the modem holds for us at most; the network refills it instantly
+#ifndef BENCH_MODEM_BUFFER
+#define BENCH_MODEM_BUFFER 8192
+#endif
+
+#ifndef BENCH_TIMEOUT
+#define BENCH_TIMEOUT 5000L
+#endif
+
+#if defined(BENCH_TRANSPARENT)
+  #define BENCH_CLIENT(client) TinyGsmClientTransparent client(modem)
+#elif defined(BENCH_TASK)
+  // The task owns the modem until the end of the test
+  #define BENCH_CLIENT(client) \
+    TinyGsmProxyClient client; \
+    TinyGsmTask<TinyGsm> task(modem); \
+    task.attach(client, 1); \
+    task.begin(); \
+    BenchTaskScope scope(task)
+#elif defined(TINY_GSM_MODEM_A6)
+  // A6 picks the mux itself on connect
+  #define BENCH_CLIENT(client) TinyGsmClient client(modem)
+#elif defined(TINY_GSM_MODEM_UBLOX)
+  #define BENCH_CLIENT(client) TinyGsmClient client(modem, 0)
+#else
+  #define BENCH_CLIENT(client) TinyGsmClient client(modem, 1)
+#endif
+
+#if defined(BENCH_TRANSPARENT)
+  #define BENCH_NAME "SIM800T"
+#elif defined(BENCH_TASK)
+  #define BENCH_NAME "SIM800P"
+#elif defined(TINY_GSM_USE_HEX)
+  #define BENCH_NAME "SIM800H"
+#elif defined(TINY_GSM_MODEM_SIM800) || defined(TINY_GSM_MODEM_SIM808) || defined(TINY_GSM_MODEM_SIM900)
+  #define BENCH_NAME "SIM800"
+#elif defined(TINY_GSM_MODEM_BG96)
+  #define BENCH_NAME "BG96"
+#elif defined(TINY_GSM_MODEM_UBLOX)
+  #define BENCH_NAME "UBLOX"
+#elif defined(TINY_GSM_MODEM_ESP8266)
+  #define BENCH_NAME "ESP8266"
+#elif defined(TINY_GSM_MODEM_A6)
+  #define BENCH_NAME "A6"
+#else
+  #error "Benchmark does not support this modem"
+#endif
+
+// What the remote end of the socket holds
+struct Server {
+  std::vector<uint8_t>  download;   // file being sent to us
+  size_t                served;     // bytes handed to the modem serial
+  size_t                announced;  // end of the data the host knows about
+  std::vector<uint8_t>  upload;     // bytes received from us
+  size_t                expect;     // upload size, for a link without framing
+  bool                  open;
+};
+
+static FakeModem  fake;
+static Server     srv;
+
+#if !defined(BENCH_TRANSPARENT)
+// Formats a modem reply; the buffer is reused, so replying allocates nothing
+static const char* fmt(const char* format, ...) __attribute__((format(printf, 1, 2)));
+static const char* fmt(const char* format, ...)
+{
+  static char buf[128];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  return buf;
+}
+#endif
+
+static size_t remaining()
+{
+  return srv.download.size() - srv.served;
+}
+
+#if !defined(BENCH_TRANSPARENT) && !defined(TINY_GSM_MODEM_ESP8266) && !defined(TINY_GSM_MODEM_A6)
+// Modems that are asked for data hold up to BENCH_MODEM_BUFFER of it
+static size_t buffered()
+{
+  return TinyGsmMin(remaining(), (size_t)BENCH_MODEM_BUFFER);
+}
+
+// Reports the buffered amount to the host
+static size_t query()
+{
+  srv.announced = srv.served + buffered();
+  return buffered();
+}
+
+// Modems raise a data URC only for data arriving into an empty buffer,
+// i.e. once the host has read everything it was told about
+static bool arrived()
+{
+  if (!srv.open || !remaining() || srv.served < srv.announced) return false;
+  query();
+  return true;
+}
+#endif
+
+// Sends up to `max` bytes of the download to the host, returns the count
+static size_t serve(size_t max)
+{
+  size_t len = TinyGsmMin(max, remaining());
+  fake.reply(srv.download.data() + srv.served, len);
+  srv.served += len;
+  return len;
+}
+
+static void acceptUpload(FakeModem& m, const uint8_t* data, size_t len)
+{
+  srv.upload.insert(srv.upload.end(), data, data + len);
+}
+
+/*
+ * Per-driver modem scripts
+ */
+
+#if defined(BENCH_TRANSPARENT)
+
+static void script()
+{
+  fake.on("+++", "\r\nOK\r\n");
+  fake.on("AT+CIPCLOSE", [](FakeModem& m, const char* cmd) {
+    m.reply(srv.open ? "\r\nCLOSE OK\r\n" : "\r\nERROR\r\n");
+    srv.open = false;
+  });
+  fake.on("AT+CIPSTART=", [](FakeModem& m, const char* cmd) {
+    srv.open = true;
+    m.reply("\r\nOK\r\n\r\nCONNECT\r\n");
+    // From here on, everything the host writes is payload
+    m.receiveData(srv.expect, acceptUpload);
+  });
+}
+
+// The UART is a raw pipe; the modem forwards data while the host has room
+static void pump(size_t received)
+{
+  if (!srv.open) return;
+  size_t pending = srv.served - received;
+  if (pending < BENCH_MODEM_BUFFER) serve(BENCH_MODEM_BUFFER - pending);
+}
+
+#elif defined(TINY_GSM_MODEM_SIM800) || defined(TINY_GSM_MODEM_SIM808) || defined(TINY_GSM_MODEM_SIM900)
+
+static void script()
+{
+  fake.on("AT+CIPSSL=", "\r\nOK\r\n");
+  fake.on("AT+CIPCLOSE=", [](FakeModem& m, const char* cmd) {
+    m.reply(srv.open ? "\r\n1, CLOSE OK\r\n" : "\r\nERROR\r\n");
+    srv.open = false;
+  });
+  fake.on("AT+CIPSTART=", [](FakeModem& m, const char* cmd) {
+    srv.open = true;
+    m.reply("\r\nOK\r\n\r\n1, CONNECT OK\r\n");
+    if (arrived()) m.reply("\r\n+CIPRXGET: 1,1\r\n");
+  });
+  fake.on("AT+CIPSTATUS=", [](FakeModem& m, const char* cmd) {
+    m.reply(fmt("\r\n+CIPSTATUS: 1,0,\"TCP\",\"1.2.3.4\",\"80\",\"%s\"\r\n\r\nOK\r\n",
+                srv.open ? "CONNECTED" : "CLOSED"));
+  });
+  fake.on("AT+CIPSTATUS", [](FakeModem& m, const char* cmd) {
+    m.reply("\r\nOK\r\n\r\nSTATE: IP PROCESSING\r\n\r\n");
+    for (int mux = 0; mux <= 5; mux++) {
+      m.reply(fmt("C: %d,0,\"TCP\",\"1.2.3.4\",\"80\",\"%s\"\r\n", mux,
+                  (mux == 1 && srv.open) ? "CONNECTED" : "INITIAL"));
+    }
+  });
+  fake.on("AT+CIPRXGET=4,", [](FakeModem& m, const char* cmd) {
+    m.reply(fmt("\r\n+CIPRXGET: 4,1,%u\r\n\r\nOK\r\n", (unsigned)query()));
+  });
+  fake.on("AT+CIPRXGET=2,", [](FakeModem& m, const char* cmd) {
+    unsigned mux, size;
+    sscanf(cmd, "AT+CIPRXGET=2,%u,%u", &mux, &size);
+    size_t len = TinyGsmMin((size_t)TinyGsmMin(size, 1460u), buffered());
+    size_t left = TinyGsmMin(remaining() - len, (size_t)BENCH_MODEM_BUFFER);
+    srv.announced = srv.served + len + left;
+    m.reply(fmt("\r\n+CIPRXGET: 2,%u,%u,%u\r\n", mux, (unsigned)len, (unsigned)left));
+    serve(len);
+    m.reply("\r\nOK\r\n");
+    if (arrived()) m.reply("\r\n+CIPRXGET: 1,1\r\n");
+  });
+  fake.on("AT+CIPRXGET=3,", [](FakeModem& m, const char* cmd) {
+    unsigned mux, size;
+    sscanf(cmd, "AT+CIPRXGET=3,%u,%u", &mux, &size);
+    size_t len = TinyGsmMin((size_t)TinyGsmMin(size, 730u), buffered());
+    size_t left = TinyGsmMin(remaining() - len, (size_t)BENCH_MODEM_BUFFER);
+    srv.announced = srv.served + len + left;
+    m.reply(fmt("\r\n+CIPRXGET: 3,%u,%u,%u\r\n", mux, (unsigned)len, (unsigned)left));
+    for (size_t i = 0; i < len; i++) {
+      m.reply(fmt("%02X", srv.download[srv.served++]));
+    }
+    m.reply("\r\nOK\r\n");
+    if (arrived()) m.reply("\r\n+CIPRXGET: 1,1\r\n");
+  });
+  fake.on("AT+CIPSEND=", [](FakeModem& m, const char* cmd) {
+    unsigned mux, len;
+    sscanf(cmd, "AT+CIPSEND=%u,%u", &mux, &len);
+    m.reply("> ");
+    m.receiveData(len, [mux](FakeModem& m, const uint8_t* data, size_t len) {
+      acceptUpload(m, data, len);
+      m.reply(fmt("\r\nDATA ACCEPT:%u,%u\r\n", mux, (unsigned)len));
+    });
+  });
+}
+
+static void pump(size_t received) {}
+
+#elif defined(TINY_GSM_MODEM_BG96)
+
+static void script()
+{
+  fake.on("AT+QICLOSE=", [](FakeModem& m, const char* cmd) {
+    srv.open = false;
+    m.reply("\r\nOK\r\n");
+  });
+  fake.on("AT+QIOPEN=", [](FakeModem& m, const char* cmd) {
+    srv.open = true;
+    m.reply("\r\nOK\r\n\r\n+QIOPEN: 1,0\r\n");
+    if (arrived()) m.reply("\r\n+QIURC: \"recv\",1\r\n");
+  });
+  // Both forms list socket 1, only the bare one leaves closed sockets out
+  fake.on("AT+QISTATE", [](FakeModem& m, const char* cmd) {
+    if (srv.open || cmd[strlen("AT+QISTATE")] == '=') {
+      m.reply(fmt("\r\n+QISTATE: 1,\"TCP\",\"1.2.3.4\",80,5087,%d,1,1,0,\"uart1\"\r\n",
+                  srv.open ? 2 : 4));
+    }
+    m.reply("\r\nOK\r\n");
+  });
+  fake.on("AT+QIRD=", [](FakeModem& m, const char* cmd) {
+    unsigned mux, size;
+    sscanf(cmd, "AT+QIRD=%u,%u", &mux, &size);
+    if (size == 0) {
+      m.reply(fmt("\r\n+QIRD: %u,%u,%u\r\n\r\nOK\r\n", (unsigned)srv.download.size(),
+                  (unsigned)srv.served, (unsigned)query()));
+      return;
+    }
+    size_t len = TinyGsmMin((size_t)TinyGsmMin(size, 1500u), buffered());
+    m.reply(fmt("\r\n+QIRD: %u\r\n", (unsigned)len));
+    serve(len);
+    m.reply("\r\n\r\nOK\r\n");
+    if (arrived()) m.reply("\r\n+QIURC: \"recv\",1\r\n");
+  });
+  fake.on("AT+QISEND=", [](FakeModem& m, const char* cmd) {
+    unsigned mux, len;
+    sscanf(cmd, "AT+QISEND=%u,%u", &mux, &len);
+    m.reply("\r\n> ");
+    m.receiveData(len, [](FakeModem& m, const uint8_t* data, size_t len) {
+      acceptUpload(m, data, len);
+      m.reply("\r\nSEND OK\r\n");
+    });
+  });
+}
+
+static void pump(size_t received) {}
+
+#elif defined(TINY_GSM_MODEM_UBLOX)
+
+static void script()
+{
+  fake.on("AT+USOCL=", [](FakeModem& m, const char* cmd) {
+    m.reply(srv.open ? "\r\nOK\r\n" : "\r\nERROR\r\n");
+    srv.open = false;
+  });
+  fake.on("AT+USOCR=", "\r\n+USOCR: 0\r\n\r\nOK\r\n");
+  fake.on("AT+USOSO=", "\r\nOK\r\n");
+  fake.on("AT+USOSEC=", "\r\nOK\r\n");
+  fake.on("AT+USOCO=", [](FakeModem& m, const char* cmd) {
+    srv.open = true;
+    m.reply("\r\nOK\r\n");
+    if (arrived()) m.reply(fmt("\r\n+UUSORD: 0,%u\r\n", (unsigned)buffered()));
+  });
+  fake.on("AT+USOCTL=", [](FakeModem& m, const char* cmd) {
+    m.reply(fmt("\r\n+USOCTL: 0,10,%d\r\n\r\nOK\r\n", srv.open ? 4 : 0));
+  });
+  fake.on("AT+USORD=", [](FakeModem& m, const char* cmd) {
+    unsigned mux, size;
+    sscanf(cmd, "AT+USORD=%u,%u", &mux, &size);
+    if (size == 0) {
+      m.reply(fmt("\r\n+USORD: %u,%u\r\n\r\nOK\r\n", mux, (unsigned)query()));
+      return;
+    }
+    size_t len = TinyGsmMin((size_t)TinyGsmMin(size, 1024u), buffered());
+    m.reply(fmt("\r\n+USORD: %u,%u,\"", mux, (unsigned)len));
+    serve(len);
+    m.reply("\"\r\n\r\nOK\r\n");
+    if (arrived()) m.reply(fmt("\r\n+UUSORD: %u,%u\r\n", mux, (unsigned)buffered()));
+  });
+  fake.on("AT+USOWR=", [](FakeModem& m, const char* cmd) {
+    unsigned mux, len;
+    sscanf(cmd, "AT+USOWR=%u,%u", &mux, &len);
+    m.reply("\r\n@");
+    m.receiveData(len, [mux](FakeModem& m, const uint8_t* data, size_t len) {
+      acceptUpload(m, data, len);
+      m.reply(fmt("\r\n+USOWR: %u,%u\r\n\r\nOK\r\n", mux, (unsigned)len));
+    });
+  });
+}
+
+static void pump(size_t received) {}
+
+#elif defined(TINY_GSM_MODEM_ESP8266) || defined(TINY_GSM_MODEM_A6)
+
+static void script()
+{
+  fake.on("AT+CIPCLOSE=", [](FakeModem& m, const char* cmd) {
+    m.reply(srv.open ? "\r\n1,CLOSED\r\n\r\nOK\r\n" : "\r\nERROR\r\n");
+    srv.open = false;
+  });
+  fake.on("AT+CIPSTART=", [](FakeModem& m, const char* cmd) {
+    srv.open = true;
+#if defined(TINY_GSM_MODEM_A6)
+    m.reply("\r\n+CIPNUM:1\r\n\r\nCONNECT OK\r\n\r\nOK\r\n");
+#else
+    m.reply("1,CONNECT\r\n\r\nOK\r\n");
+#endif
+  });
+  fake.on("AT+CIPSEND=", [](FakeModem& m, const char* cmd) {
+    unsigned mux, len;
+    sscanf(cmd, "AT+CIPSEND=%u,%u", &mux, &len);
+#if defined(TINY_GSM_MODEM_A6)
+    m.reply("\r\n>");
+#else
+    m.reply("\r\nOK\r\n> ");
+#endif
+    m.receiveData(len, [](FakeModem& m, const uint8_t* data, size_t len) {
+      acceptUpload(m, data, len);
+#if defined(TINY_GSM_MODEM_A6)
+      m.reply("\r\nOK\r\n");
+#else
+      m.reply(fmt("\r\nRecv %u bytes\r\n\r\nSEND OK\r\n", (unsigned)len));
+#endif
+    });
+  });
+}
+
+// These modems push data unsolicited; deliver the next packet once the
+// client has drained the previous one, as the driver has no flow control.
+static void pump(size_t received)
+{
+  if (!srv.open || received != srv.served || !remaining()) return;
+  size_t len = TinyGsmMin((size_t)TinyGsmMin(TINY_GSM_RX_BUFFER - 1, 1460), remaining());
+#if defined(TINY_GSM_MODEM_A6)
+  fake.reply(fmt("\r\n+CIPRCV:1,%u,", (unsigned)len));
+#else
+  fake.reply(fmt("\r\n+IPD,1,%u:", (unsigned)len));
+#endif
+  serve(len);
+}
+
+#endif
+
+/*
+ * Measurement
+ */
+
+struct Sample {
+  unsigned long wall_us;
+  clock_t       cpu;
+  unsigned long commands;
+  unsigned long allocs;
+  unsigned long wire;
+
+  static Sample now() {
+    Sample s;
+    s.wall_us  = micros();
+    s.cpu      = clock();
+    s.commands = fake.commands();
+    s.allocs   = TinyGsmHostAllocs();
+    s.wire     = fake.bytesToModem() + fake.bytesFromModem();
+    return s;
+  }
+};
+
+#if defined(BENCH_TASK)
+// The counters belong to the modem task while it runs
+static TinyGsmTask<TinyGsm>* bench_task;
+
+struct BenchTaskScope {
+  BenchTaskScope(TinyGsmTask<TinyGsm>& task) { bench_task = &task; }
+  ~BenchTaskScope() { bench_task = NULL; }
+};
+
+static Sample sample()
+{
+  Sample s;
+  bench_task->call([](TinyGsm& modem, void* arg) {
+    *static_cast<Sample*>(arg) = Sample::now();
+  }, &s);
+  return s;
+}
+#else
+static Sample sample()
+{
+  return Sample::now();
+}
+#endif
+
+static void report(const char* test, const char* file, size_t bytes, bool ok,
+                   const Sample& a, const Sample& b)
+{
+  double kb    = bytes / 1024.0;
+  double wall  = (b.wall_us - a.wall_us) / 1e6;
+  double cpu   = double(b.cpu - a.cpu) / CLOCKS_PER_SEC;
+  printf("%-8s %-9s %-14s %8u %10.1f %10.1f %8.2f %9.2f %7.2f  %s\n",
+         BENCH_NAME, test, file, (unsigned)bytes,
+         wall > 0 ? kb / wall : 0.0,
+         cpu * 1e6 / kb,
+         (b.commands - a.commands) / kb,
+         (b.allocs - a.allocs) / kb,
+         double(b.wire - a.wire) / bytes,
+         ok ? "ok" : "FAILED");
+}
+
+static bool download(TinyGsm& modem, const char* name, const std::vector<uint8_t>& data)
+{
+  fake.reset();
+  srv = Server();
+  srv.download = data;
+  script();
+
+  BENCH_CLIENT(client);
+  if (!client.connect("bench.local", 80)) {
+    printf("%-8s download  %-14s connect failed\n", BENCH_NAME, name);
+    return false;
+  }
+
+  std::vector<uint8_t> got;
+  got.reserve(data.size());
+  uint8_t buf[BENCH_READ_CHUNK];
+
+  Sample a = sample();
+  unsigned long last = millis();
+  while (got.size() < data.size() && millis() - last < BENCH_TIMEOUT) {
+    pump(got.size());
+    int avail = client.available();
+    if (avail <= 0) continue;
+    int n = client.read(buf, TinyGsmMin((size_t)avail, sizeof(buf)));
+    if (n > 0) {
+      got.insert(got.end(), buf, buf + n);
+      last = millis();
+    }
+  }
+  Sample b = sample();
+
+  bool ok = (got == data);
+  report("download", name, data.size(), ok, a, b);
+  return ok;
+}
+
+static bool upload(TinyGsm& modem, const char* name, const std::vector<uint8_t>& data)
+{
+  fake.reset();
+  srv = Server();
+  srv.expect = data.size();
+  script();
+
+  BENCH_CLIENT(client);
+  if (!client.connect("bench.local", 80)) {
+    printf("%-8s upload    %-14s connect failed\n", BENCH_NAME, name);
+    return false;
+  }
+
+  Sample a = sample();
+  size_t sent = 0;
+  while (sent < data.size()) {
+    size_t len = TinyGsmMin((size_t)BENCH_WRITE_CHUNK, data.size() - sent);
+    size_t n = client.write(data.data() + sent, len);
+    if (n == 0) break;
+    sent += n;
+  }
+  client.flush();
+  Sample b = sample();
+
+  bool ok = (srv.upload == data);
+  report("upload", name, data.size(), ok, a, b);
+  return ok;
+}
+
+static bool readFile(const char* path, std::vector<uint8_t>& data)
+{
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    data.insert(data.end(), buf, buf + n);
+  }
+  fclose(f);
+  return true;
+}
+
+void setup() {}
+void loop() {}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s file...\n", argv[0]);
+    return 2;
+  }
+
+  TinyGsm modem(fake);
+  bool ok = true;
+
+  printf("%-8s %-9s %-14s %8s %10s %10s %8s %9s %7s\n",
+         "modem", "test", "file", "bytes", "KB/s", "cpu us/KB", "AT/KB", "alloc/KB", "wire/B");
+
+  for (int i = 1; i < argc; i++) {
+    std::vector<uint8_t> data;
+    if (!readFile(argv[i], data) || data.empty()) {
+      fprintf(stderr, "Cannot read %s\n", argv[i]);
+      return 2;
+    }
+    const char* name = strrchr(argv[i], '/');
+    name = name ? name + 1 : argv[i];
+
+    ok &= download(modem, name, data);
+    ok &= upload(modem, name, data);
+  }
+  return ok ? 0 : 1;
+}
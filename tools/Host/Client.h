@@ -0,0 +1,18 @@
+/**
+ * @file       Client.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * TinyGsmCommon.h includes <Client.h> when no Arduino core is present,
+ * so route it to the bundled ArduinoCompat one.
+ */
+
+#ifndef HostClient_h
+#define HostClient_h
+
+#include "Arduino.h"
+#include <ArduinoCompat/Client.h>
+
+#endif
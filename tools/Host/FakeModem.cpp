@@ -0,0 +1,181 @@
+/**
+ * @file       FakeModem.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ */
+
+#include "FakeModem.h"
+
+FakeModem::FakeModem()
+{
+  reset();
+}
+
+void FakeModem::reset()
+{
+  _expected.clear();
+  _rules.clear();
+  _unknown = "\r\nERROR\r\n";
+  _unhandled.clear();
+  _out.clear();
+  _outPos = 0;
+  _line.clear();
+  _afterCr = false;
+  _dataLeft = 0;
+  _data.clear();
+  _dataHandler = nullptr;
+  _commands = 0;
+  _bytesIn = 0;
+  _bytesOut = 0;
+}
+
+void FakeModem::expect(const char* cmd, const char* reply)
+{
+  _expected.push_back(Rule { cmd, reply, nullptr });
+}
+
+void FakeModem::on(const char* prefix, const char* reply)
+{
+  _rules.push_back(Rule { prefix, reply, nullptr });
+}
+
+void FakeModem::on(const char* prefix, Handler handler)
+{
+  _rules.push_back(Rule { prefix, "", handler });
+}
+
+void FakeModem::onUnknown(const char* reply)
+{
+  _unknown = reply;
+}
+
+void FakeModem::reply(const char* str)
+{
+  reply((const uint8_t*)str, strlen(str));
+}
+
+void FakeModem::reply(const String& str)
+{
+  reply((const uint8_t*)str.c_str(), str.length());
+}
+
+void FakeModem::reply(const uint8_t* data, size_t len)
+{
+  // Compact once everything queued so far has been consumed
+  if (_outPos && _outPos == _out.size()) {
+    _out.clear();
+    _outPos = 0;
+  }
+  _out.insert(_out.end(), data, data + len);
+}
+
+void FakeModem::receiveData(size_t len, DataHandler handler)
+{
+  _dataLeft = len;
+  _data.clear();
+  _dataHandler = handler;
+  if (!len && handler) {
+    _dataHandler = nullptr;
+    handler(*this, NULL, 0);
+  }
+}
+
+int FakeModem::available()
+{
+  return _out.size() - _outPos;
+}
+
+int FakeModem::read()
+{
+  if (_outPos >= _out.size()) return -1;
+  _bytesOut++;
+  return _out[_outPos++];
+}
+
+int FakeModem::peek()
+{
+  if (_outPos >= _out.size()) return -1;
+  return _out[_outPos];
+}
+
+size_t FakeModem::readBytes(char* buffer, size_t length)
+{
+  size_t n = std::min(length, _out.size() - _outPos);
+  memcpy(buffer, _out.data() + _outPos, n);
+  _outPos += n;
+  _bytesOut += n;
+  if (n < length) {
+    n += Stream::readBytes(buffer + n, length - n);
+  }
+  return n;
+}
+
+size_t FakeModem::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t FakeModem::write(const uint8_t* buf, size_t size)
+{
+  _bytesIn += size;
+  for (size_t i = 0; i < size; i++) {
+    uint8_t c = buf[i];
+    // The LF of a CRLF belongs to the command, not to a payload it started
+    if (_afterCr) {
+      _afterCr = false;
+      if (c == '\n') continue;
+    }
+    if (_dataLeft) {
+      _data.push_back(c);
+      if (--_dataLeft == 0 && _dataHandler) {
+        DataHandler handler = _dataHandler;
+        _dataHandler = nullptr;
+        handler(*this, _data.data(), _data.size());
+      }
+      continue;
+    }
+    if (c == '\n' && _line.empty()) continue;
+    if (c == '\r' || c == '\n' || c == 0x1A) {
+      _afterCr = (c == '\r');
+      dispatch(_line);
+      _line.clear();
+      continue;
+    }
+    _line += (char)c;
+    if (_line == "+++") {
+      dispatch(_line);
+      _line.clear();
+    }
+  }
+  return size;
+}
+
+void FakeModem::dispatch(const std::string& cmd)
+{
+  _commands++;
+  if (!_expected.empty() && cmd.compare(0, _expected.front().prefix.size(), _expected.front().prefix) == 0) {
+    Rule rule = _expected.front();
+    _expected.pop_front();
+    run(rule, cmd);
+    return;
+  }
+  for (size_t i = 0; i < _rules.size(); i++) {
+    if (cmd.compare(0, _rules[i].prefix.size(), _rules[i].prefix) == 0) {
+      run(_rules[i], cmd);
+      return;
+    }
+  }
+  _unhandled.push_back(cmd);
+  reply(_unknown.c_str());
+}
+
+void FakeModem::run(const Rule& rule, const std::string& cmd)
+{
+  if (rule.handler) {
+    rule.handler(*this, cmd.c_str());
+  } else {
+    reply(rule.reply.c_str());
+  }
+}
@@ -0,0 +1,117 @@
+/**
+ * @file       FakeModem.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * A Stream that plays the modem side of the serial link.
+ * Everything the library writes is split into command lines (terminated by
+ * CR, Ctrl-Z or a bare "+++") and answered from a script:
+ *
+ *   FakeModem modem;
+ *   modem.expect("AT+CPIN?", "\r\n+CPIN: READY\r\n\r\nOK\r\n");  // once, in order
+ *   modem.on("AT+CSQ", "\r\n+CSQ: 20,0\r\n\r\nOK\r\n");          // every time
+ *   modem.on("AT+CIPSEND=", [](FakeModem& m, const char* cmd) {  // computed
+ *     m.reply("> ");
+ *     m.receiveData(len, ...);
+ *   });
+ *
+ * Replies are queued immediately, so the library never waits on the host.
+ */
+
+#ifndef FakeModem_h
+#define FakeModem_h
+
+#include "Arduino.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+class FakeModem : public Stream
+{
+public:
+  typedef std::function<void(FakeModem& modem, const char* cmd)> Handler;
+  typedef std::function<void(FakeModem& modem, const uint8_t* data, size_t len)> DataHandler;
+
+  FakeModem();
+
+  /*
+   * Script
+   */
+
+  // One-shot reply, matched against the next command only
+  void expect(const char* cmd, const char* reply);
+  // Persistent replies, matched by command prefix in registration order
+  void on(const char* prefix, const char* reply);
+  void on(const char* prefix, Handler handler);
+  // Reply used when nothing matches (default: ERROR)
+  void onUnknown(const char* reply);
+  // Drop all rules, pending output and counters
+  void reset();
+
+  /*
+   * Modem side
+   */
+
+  void reply(const char* str);
+  void reply(const String& str);
+  void reply(const uint8_t* data, size_t len);
+  // Treat the next `len` written bytes as payload instead of commands
+  void receiveData(size_t len, DataHandler handler);
+  // Commands that matched no rule
+  const std::vector<std::string>& unhandled() const { return _unhandled; }
+
+  /*
+   * Counters
+   */
+
+  unsigned long commands() const { return _commands; }
+  unsigned long bytesToModem() const { return _bytesIn; }
+  unsigned long bytesFromModem() const { return _bytesOut; }
+
+  /*
+   * Stream
+   */
+
+  virtual int available();
+  virtual int read();
+  virtual int peek();
+  virtual size_t readBytes(char* buffer, size_t length);
+  virtual size_t write(uint8_t c);
+  virtual size_t write(const uint8_t* buf, size_t size);
+  virtual void flush() {}
+  using Print::write;
+  using Stream::readBytes;
+
+private:
+  struct Rule {
+    std::string prefix;
+    std::string reply;
+    Handler     handler;
+  };
+
+  void dispatch(const std::string& cmd);
+  void run(const Rule& rule, const std::string& cmd);
+
+  std::deque<Rule>          _expected;
+  std::vector<Rule>         _rules;
+  std::string               _unknown;
+  std::vector<std::string>  _unhandled;
+
+  std::vector<uint8_t>      _out;
+  size_t                    _outPos;
+  std::string               _line;
+  bool                      _afterCr;
+
+  size_t                    _dataLeft;
+  std::vector<uint8_t>      _data;
+  DataHandler               _dataHandler;
+
+  unsigned long             _commands;
+  unsigned long             _bytesIn;
+  unsigned long             _bytesOut;
+};
+
+#endif
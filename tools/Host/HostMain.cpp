@@ -0,0 +1,21 @@
+/**
+ * @file       HostMain.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Runs an Arduino sketch (setup/loop) as a regular Linux program.
+ */
+
+#include "Arduino.h"
+
+int main()
+{
+  setup();
+  for (;;) {
+    loop();
+    yield();
+  }
+  return 0;
+}
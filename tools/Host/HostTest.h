@@ -0,0 +1,90 @@
+/**
+ * @file       HostTest.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Checks for the host unit tests (Test*.cpp, run by "make test").
+ * Every test file is its own program:
+ *
+ *   static void testSomething() {
+ *     CHECK(cond);
+ *     CHECK_EQ(got, expected);   // integers
+ *     CHECK_STR(got, expected);  // C strings
+ *   }
+ *
+ *   int main() {
+ *     RUN(testSomething);
+ *     return testResult();
+ *   }
+ */
+
+#ifndef HostTest_h
+#define HostTest_h
+
+#include "Arduino.h"
+
+static int test_checks = 0;
+static int test_failed = 0;
+static const char* test_name = "";
+
+#define CHECK(cond) \
+  testCheck((cond), __FILE__, __LINE__, #cond)
+
+#define CHECK_EQ(got, expected) \
+  testCheckEq((long long)(got), (long long)(expected), __FILE__, __LINE__, #got)
+
+#define CHECK_STR(got, expected) \
+  testCheckStr((got), (expected), __FILE__, __LINE__, #got)
+
+#define RUN(test) \
+  do { test_name = #test; test(); } while (0)
+
+static inline bool testCheck(bool ok, const char* file, int line, const char* what)
+{
+  test_checks++;
+  if (!ok) {
+    test_failed++;
+    printf("%s:%d: %s: CHECK(%s) failed\n", file, line, test_name, what);
+  }
+  return ok;
+}
+
+static inline bool testCheckEq(long long got, long long expected,
+                               const char* file, int line, const char* what)
+{
+  test_checks++;
+  if (got != expected) {
+    test_failed++;
+    printf("%s:%d: %s: %s is %lld, expected %lld\n", file, line, test_name, what, got, expected);
+    return false;
+  }
+  return true;
+}
+
+static inline bool testCheckStr(const char* got, const char* expected,
+                                const char* file, int line, const char* what)
+{
+  test_checks++;
+  if (strcmp(got ? got : "(null)", expected ? expected : "(null)")) {
+    test_failed++;
+    printf("%s:%d: %s: %s is \"%s\", expected \"%s\"\n", file, line, test_name, what,
+           got ? got : "(null)", expected ? expected : "(null)");
+    return false;
+  }
+  return true;
+}
+
+// Name in the summary line, tests built more than once set it apart
+#if !defined(TEST_NAME)
+#define TEST_NAME __BASE_FILE__
+#endif
+
+static inline int testResult()
+{
+  printf("%-28s %5d checks, %d failed\n", TEST_NAME, test_checks, test_failed);
+  return test_failed ? 1 : 0;
+}
+
+#endif
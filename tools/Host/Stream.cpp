@@ -0,0 +1,176 @@
+/**
+ * @file       Stream.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ */
+
+#include "Arduino.h"
+
+int Stream::timedRead()
+{
+  int c;
+  _startMillis = millis();
+  do {
+    c = read();
+    if (c >= 0) return c;
+    yield();
+  } while (millis() - _startMillis < _timeout);
+  return -1;
+}
+
+int Stream::timedPeek()
+{
+  int c;
+  _startMillis = millis();
+  do {
+    c = peek();
+    if (c >= 0) return c;
+    yield();
+  } while (millis() - _startMillis < _timeout);
+  return -1;
+}
+
+int Stream::peekNextDigit(bool detectDecimal)
+{
+  int c;
+  while (1) {
+    c = timedPeek();
+    if (c < 0 ||
+        c == '-' ||
+        (c >= '0' && c <= '9') ||
+        (detectDecimal && c == '.')) return c;
+    read();
+  }
+}
+
+bool Stream::find(const char *target)
+{
+  return find(target, strlen(target));
+}
+
+bool Stream::find(const char *target, size_t length)
+{
+  if (length == 0) return true;
+  size_t index = 0;
+  int c;
+  while ((c = timedRead()) > 0) {
+    if (c != target[index]) {
+      index = (c == target[0]) ? 1 : 0;
+      continue;
+    }
+    if (++index >= length) return true;
+  }
+  return false;
+}
+
+bool Stream::findUntil(const char *target, const char *terminator)
+{
+  size_t tlen = strlen(target);
+  size_t elen = strlen(terminator);
+  size_t index = 0;
+  size_t termIndex = 0;
+  int c;
+  while ((c = timedRead()) > 0) {
+    if (c == target[index]) {
+      if (++index >= tlen) return true;
+    } else {
+      index = (c == target[0]) ? 1 : 0;
+    }
+    if (elen && c == terminator[termIndex]) {
+      if (++termIndex >= elen) return false;
+    } else {
+      termIndex = 0;
+    }
+  }
+  return false;
+}
+
+long Stream::parseInt()
+{
+  bool isNegative = false;
+  long value = 0;
+  int c = peekNextDigit(false);
+  if (c < 0) return 0;
+  do {
+    if (c == '-') {
+      isNegative = true;
+    } else if (c >= '0' && c <= '9') {
+      value = value * 10 + c - '0';
+    }
+    read();
+    c = timedPeek();
+  } while (c >= '0' && c <= '9');
+  return isNegative ? -value : value;
+}
+
+float Stream::parseFloat()
+{
+  bool isNegative = false;
+  bool isFraction = false;
+  long value = 0;
+  float fraction = 1.0;
+  int c = peekNextDigit(true);
+  if (c < 0) return 0;
+  do {
+    if (c == '-') {
+      isNegative = true;
+    } else if (c == '.') {
+      isFraction = true;
+    } else if (c >= '0' && c <= '9') {
+      value = value * 10 + c - '0';
+      if (isFraction) fraction *= 0.1;
+    }
+    read();
+    c = timedPeek();
+  } while ((c >= '0' && c <= '9') || (c == '.' && !isFraction));
+  if (isNegative) value = -value;
+  return isFraction ? value * fraction : value;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0) break;
+    *buffer++ = (char)c;
+    count++;
+  }
+  return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length)
+{
+  size_t index = 0;
+  while (index < length) {
+    int c = timedRead();
+    if (c < 0 || c == terminator) break;
+    *buffer++ = (char)c;
+    index++;
+  }
+  return index;
+}
+
+String Stream::readString()
+{
+  String ret;
+  int c = timedRead();
+  while (c >= 0) {
+    ret += (char)c;
+    c = timedRead();
+  }
+  return ret;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+  String ret;
+  int c = timedRead();
+  while (c >= 0 && c != terminator) {
+    ret += (char)c;
+    c = timedRead();
+  }
+  return ret;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file       Stream.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ */
+
+#ifndef Stream_h
+#define Stream_h
+
+#include "Print.h"
+
+class Stream : public Print
+{
+public:
+  Stream() : _timeout(1000), _startMillis(0) {}
+
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  unsigned long getTimeout(void) { return _timeout; }
+
+  bool find(const char *target);
+  bool find(const char *target, size_t length);
+  bool find(char target) { return find(&target, 1); }
+  bool findUntil(const char *target, const char *terminator);
+
+  long parseInt();
+  float parseFloat();
+
+  virtual size_t readBytes(char *buffer, size_t length);
+  virtual size_t readBytes(uint8_t *buffer, size_t length) {
+    return readBytes((char *)buffer, length);
+  }
+  size_t readBytesUntil(char terminator, char *buffer, size_t length);
+
+  String readString();
+  String readStringUntil(char terminator);
+
+protected:
+  int timedRead();
+  int timedPeek();
+  int peekNextDigit(bool detectDecimal);
+
+  unsigned long _timeout;
+  unsigned long _startMillis;
+};
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ * @file       TestAsync.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * SIM800 non-blocking operations: other sockets keep working while a
+ * connectAsync() is pending, pollConnect() only reports its own socket,
+ * a failed TLS handshake ends an open, and blocking commands never take
+ * the answer of a command in flight.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+static int csq_sent;
+
+static void script()
+{
+  fake.reset();
+  csq_sent = 0;
+  fake.onUnknown("\r\nOK\r\n");
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+  // Socket 1 takes its time, socket 2 connects at once
+  fake.on("AT+CIPSTART=", [](FakeModem& m, const char* cmd) {
+    m.reply(cmd[12] == '2' ? "\r\nOK\r\n\r\n2, CONNECT OK\r\n" : "\r\nOK\r\n");
+  });
+  fake.on("AT+CIPRXGET=4,2", "\r\n+CIPRXGET: 4,2,5\r\n\r\nOK\r\n");
+  fake.on("AT+CIPRXGET=2,2,", "\r\n+CIPRXGET: 2,2,5,0\r\nhello\r\nOK\r\n");
+  fake.on("AT+CSQ", [](FakeModem& m, const char* cmd) {
+    csq_sent++;
+    m.reply("\r\n+CSQ: 20,0\r\n\r\nOK\r\n");
+  });
+  fake.on("AT+CGMI", "\r\n+TEST: 1\r\n\r\nSIMCOM_Ltd\r\n\r\nOK\r\n");
+}
+
+static void testSocketsWhilePending()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient first(modem, 1);
+  TinyGsmClient second(modem, 2);
+  CHECK(second.connect("example.com", 80));
+
+  CHECK(first.connectAsync("example.org", 80));
+  CHECK_EQ((int)first.pollConnect(), (int)AsyncStatus::PENDING);
+  CHECK_EQ((int)second.pollConnect(), (int)AsyncStatus::DONE);
+
+  // Data for the second socket is fetched meanwhile
+  fake.reply("\r\n+CIPRXGET: 1,2\r\n");
+  modem.maintain();
+  CHECK_EQ(second.available(), 5);
+  char buf[8] = { 0 };
+  CHECK_EQ(second.read((uint8_t*)buf, 5), 5);
+  CHECK_STR(buf, "hello");
+  CHECK_EQ((int)first.pollConnect(), (int)AsyncStatus::PENDING);
+
+  fake.reply("\r\n1, CONNECT OK\r\n");
+  modem.maintain();
+  CHECK_EQ((int)first.pollConnect(), (int)AsyncStatus::DONE);
+  CHECK(first.connected());
+}
+
+static void testConnectFails()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient first(modem, 1);
+  CHECK(first.connectAsync("example.org", 80));
+  // +CIPSSL, then +CIPSTART
+  for (int i = 0; i < 4; i++) {
+    CHECK_EQ((int)first.pollConnect(), (int)AsyncStatus::PENDING);
+  }
+  fake.reply("\r\n1, CONNECT FAIL\r\n");
+  CHECK_EQ((int)first.pollConnect(), (int)AsyncStatus::FAILED);
+  CHECK(!first.connected());
+}
+
+// "<n>, CLOSE OK" instead of CONNECT FAIL, when the TLS handshake failed
+static void testHandshakeFails()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient first(modem, 1);
+  CHECK(first.connectStart("example.org", 443));
+  CHECK(first.connecting());
+  fake.reply("\r\n1, CLOSE OK\r\n");
+  modem.maintain();
+  CHECK(!first.connecting());
+  CHECK(!first.connected());
+
+  CHECK(first.connectAsync("example.org", 443));
+  for (int i = 0; i < 4; i++) {
+    CHECK_EQ((int)first.pollConnect(), (int)AsyncStatus::PENDING);
+  }
+  fake.reply("\r\n1, CLOSE OK\r\n");
+  CHECK_EQ((int)first.pollConnect(), (int)AsyncStatus::FAILED);
+  CHECK(!first.connected());
+}
+
+static TinyGsm* urc_modem;
+static int urc_csq;
+static uint8_t cgmi_index;
+static std::string cgmi;
+
+// Runs while the queued +CGMI is in flight
+static void handleTest(void* arg, Stream& stream, TinyGsmResponse& data)
+{
+  stream.readStringUntil('\n');
+  urc_csq = urc_modem->getSignalQuality();
+}
+
+static void onCgmi(void* arg, uint8_t index, TinyGsmResponse& data)
+{
+  cgmi_index = index;
+  cgmi = data.c_str();
+}
+
+static void testBlockingRejectedInFlight()
+{
+  script();
+  TinyGsm modem(fake);
+  urc_modem = &modem;
+  urc_csq = -1;
+  cgmi_index = 0;
+  CHECK(modem.addUrcHandler(GF("+TEST:"), handleTest));
+  CHECK(modem.queueAT("+CGMI", onCgmi));
+  for (int i = 0; i < 10 && modem.queuedAT(); i++) {
+    modem.maintain();
+  }
+  CHECK_EQ(urc_csq, 99);
+  CHECK_EQ(csq_sent, 0);
+  CHECK_EQ(cgmi_index, 1);
+  CHECK(cgmi.find("SIMCOM_Ltd") != std::string::npos);
+
+  // Once nothing is in flight, blocking commands work again
+  CHECK_EQ(modem.getSignalQuality(), 20);
+  CHECK_EQ(csq_sent, 1);
+}
+
+int main()
+{
+  RUN(testSocketsWhilePending);
+  RUN(testConnectFails);
+  RUN(testHandshakeFails);
+  RUN(testBlockingRejectedInFlight);
+  return testResult();
+}
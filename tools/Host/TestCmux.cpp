@@ -0,0 +1,270 @@
+/**
+ * @file       TestCmux.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * GSM 07.10 framing of TinyGsmCmux against a scripted modem side:
+ * opening channels, splitting and demultiplexing, resync after bad
+ * frames, flow control of a channel nobody reads (also with a modem
+ * that ignores it), and modem requests.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#include <TinyGsmClient.h>
+#include <TinyGsmCmux.h>
+#include "HostTest.h"
+
+#include <string>
+#include <vector>
+
+struct Frame
+{
+  uint8_t     dlci;
+  uint8_t     control;
+  std::string data;
+};
+
+// The modem side: answers AT+CMUX=0 and SABM, decodes the frames it gets
+class CmuxPeer : public Stream
+{
+public:
+  CmuxPeer() : mux(false), pos(0) {}
+
+  virtual int available() { return toHost.size() - pos; }
+  virtual int read() { return pos < toHost.size() ? (uint8_t)toHost[pos++] : -1; }
+  virtual int peek() { return pos < toHost.size() ? (uint8_t)toHost[pos] : -1; }
+  virtual size_t write(uint8_t c) {
+    fromHost += (char)c;
+    parse();
+    return 1;
+  }
+  using Print::write;
+
+  void send(const std::string& raw) { toHost += raw; }
+
+  void send(uint8_t dlci, uint8_t control, const std::string& data) {
+    uint8_t head[3] = { (uint8_t)((dlci << 2) | 0x03), control, (uint8_t)((data.size() << 1) | 1) };
+    std::string f;
+    f += (char)0xF9;
+    f.append((const char*)head, 3);
+    f += data;
+    f += (char)TinyGsmCmuxFcs(head, 3);
+    f += (char)0xF9;
+    send(f);
+  }
+
+  // Frames the library sent, optionally only UIH data of one DLCI
+  std::string uih(uint8_t dlci) {
+    std::string all;
+    for (size_t i = 0; i < frames.size(); i++) {
+      if (frames[i].dlci == dlci && frames[i].control == 0xEF) all += frames[i].data;
+    }
+    return all;
+  }
+
+  // Flow control of the last MSC for a DLCI: 1 hold, 0 go, -1 none
+  int held(uint8_t dlci) {
+    int last = -1;
+    for (size_t i = 0; i < frames.size(); i++) {
+      const std::string& d = frames[i].data;
+      if (frames[i].dlci == 0 && d.size() == 4 && (uint8_t)d[0] == 0xE3 &&
+          ((uint8_t)d[2] >> 2) == dlci) {
+        last = ((uint8_t)d[3] & 0x02) ? 1 : 0;
+      }
+    }
+    return last;
+  }
+
+  bool                mux;
+  std::string         toHost;
+  size_t              pos;
+  std::string         fromHost;
+  std::vector<Frame>  frames;
+
+private:
+  void parse() {
+    if (!mux) {
+      if (fromHost == "AT+CMUX=0\r\n") {
+        fromHost.clear();
+        mux = true;
+        send("\r\nOK\r\n");
+      }
+      return;
+    }
+    // Flag, address, control, length, data, FCS, flag
+    while (fromHost.size() >= 6) {
+      if ((uint8_t)fromHost[0] != 0xF9) {
+        fromHost.erase(0, 1);
+        continue;
+      }
+      size_t len = (uint8_t)fromHost[3] >> 1;
+      if (fromHost.size() < len + 6) return;
+      Frame f;
+      f.dlci = (uint8_t)fromHost[1] >> 2;
+      f.control = (uint8_t)fromHost[2] & ~0x10;
+      f.data = fromHost.substr(4, len);
+      CHECK_EQ((uint8_t)fromHost[4 + len], TinyGsmCmuxFcs((const uint8_t*)fromHost.data() + 1, 3));
+      CHECK_EQ((uint8_t)fromHost[5 + len], 0xF9);
+      fromHost.erase(0, len + 6);
+      frames.push_back(f);
+      if (f.control == 0x2F) {
+        send(f.dlci, 0x63 | 0x10, "");  // UA
+      }
+    }
+  }
+};
+
+static std::string drain(TinyGsmCmuxChannel& ch)
+{
+  std::string got;
+  while (ch.available()) got += (char)ch.read();
+  return got;
+}
+
+// The SABM example of the specification: F9 03 3F 01 1C F9
+static void testFcs()
+{
+  const uint8_t sabm[] = { 0x03, 0x3F, 0x01 };
+  CHECK_EQ(TinyGsmCmuxFcs(sabm, 3), 0x1C);
+}
+
+static void testBegin()
+{
+  CmuxPeer peer;
+  TinyGsmCmux cmux(peer);
+  CHECK(cmux.begin(2));
+  CHECK(cmux.channel(1).isOpen());
+  CHECK(cmux.channel(2).isOpen());
+  // SABM 0, SABM 1 and its MSC, SABM 2 and its MSC
+  CHECK_EQ(peer.frames.size(), 5);
+  CHECK_EQ(peer.frames[0].dlci, 0);
+  CHECK_EQ(peer.frames[0].control, 0x2F);
+  CHECK_EQ(peer.frames[1].dlci, 1);
+  CHECK_EQ(peer.frames[3].dlci, 2);
+  CHECK_EQ(peer.held(1), 0);
+  CHECK_EQ(peer.held(2), 0);
+}
+
+static void testData()
+{
+  CmuxPeer peer;
+  TinyGsmCmux cmux(peer);
+  CHECK(cmux.begin(2));
+  peer.send(2, 0xEF, "+CIPRXGET: 1,1\r\n");
+  peer.send(1, 0xEF, "\r\nOK\r\n");
+  CHECK_STR(drain(cmux.channel(1)).c_str(), "\r\nOK\r\n");
+  CHECK_STR(drain(cmux.channel(2)).c_str(), "+CIPRXGET: 1,1\r\n");
+
+  // Split into frames of at most TINY_GSM_CMUX_FRAME
+  std::string payload;
+  for (int i = 0; i < 300; i++) payload += (char)(i * 7);
+  size_t before = peer.frames.size();
+  CHECK_EQ(cmux.channel(2).write((const uint8_t*)payload.data(), payload.size()), 300);
+  CHECK_EQ(peer.frames.size() - before, 3);
+  CHECK(peer.uih(2) == payload);
+  CHECK(peer.uih(1).empty());
+}
+
+// Line noise and a frame with a bad FCS are skipped
+static void testResync()
+{
+  CmuxPeer peer;
+  TinyGsmCmux cmux(peer);
+  CHECK(cmux.begin(2));
+  peer.send("\x01\x02garbage");
+  std::string bad;
+  bad += (char)0xF9;
+  bad += "\x07\xEF\x05" "ab";
+  bad += (char)0x00;  // Wrong FCS
+  bad += (char)0xF9;
+  peer.send(bad);
+  peer.send(1, 0xEF, "good");
+  CHECK_STR(drain(cmux.channel(1)).c_str(), "good");
+}
+
+// A channel nobody reads holds the modem off instead of stalling the link
+static void testUnreadChannel()
+{
+  CmuxPeer peer;
+  TinyGsmCmux cmux(peer);
+  CHECK(cmux.begin(2));
+  std::string chunk(TINY_GSM_CMUX_FRAME, 'x');
+  int sent = 0;
+  // The modem stops once told to, one frame may still be on the way
+  while (peer.held(1) != 1 && sent < 20) {
+    peer.send(1, 0xEF, chunk);
+    sent++;
+    peer.send(2, 0xEF, "ping");
+    CHECK_STR(drain(cmux.channel(2)).c_str(), "ping");
+  }
+  CHECK_EQ(peer.held(1), 1);
+  CHECK_EQ(peer.held(2), 0);
+  peer.send(1, 0xEF, chunk);
+  sent++;
+  cmux.poll();
+  CHECK(!cmux.channel(1).getOverflow());
+
+  // Nothing was lost
+  std::string got = drain(cmux.channel(1));
+  CHECK_EQ(got.size(), sent * TINY_GSM_CMUX_FRAME);
+  CHECK(got == std::string(got.size(), 'x'));
+  cmux.poll();
+  CHECK_EQ(peer.held(1), 0);
+}
+
+// A modem that ignores the hold: what does not fit is dropped, and told
+static void testHoldIgnored()
+{
+  CmuxPeer peer;
+  TinyGsmCmux cmux(peer);
+  CHECK(cmux.begin(2));
+  std::string chunk(100, 'x');
+  int frames = TINY_GSM_CMUX_BUFFER / 100 + 2;
+  for (int i = 0; i < frames; i++) peer.send(1, 0xEF, chunk);
+  peer.send(2, 0xEF, "still here");
+  CHECK_STR(drain(cmux.channel(2)).c_str(), "still here");
+  CHECK_EQ(peer.held(1), 1);
+  CHECK(cmux.channel(1).getOverflow());
+  CHECK(!cmux.channel(2).getOverflow());
+
+  // The rest is intact
+  std::string got = drain(cmux.channel(1));
+  CHECK_EQ(got.size(), (TINY_GSM_CMUX_BUFFER / 100) * 100);
+  CHECK(got == std::string(got.size(), 'x'));
+  cmux.channel(1).clearOverflow();
+  CHECK(!cmux.channel(1).getOverflow());
+}
+
+// DISC closes the channel, MSC commands are answered
+static void testModemRequests()
+{
+  CmuxPeer peer;
+  TinyGsmCmux cmux(peer);
+  CHECK(cmux.begin(2));
+  size_t before = peer.frames.size();
+  peer.send(2, 0x43 | 0x10, "");
+  cmux.poll();
+  CHECK(!cmux.channel(2).isOpen());
+  CHECK_EQ(cmux.channel(2).write((const uint8_t*)"x", 1), 0);
+  CHECK_EQ(peer.frames.size(), before + 1);
+  CHECK_EQ(peer.frames[before].control, 0x63);
+
+  peer.send(0, 0xEF, std::string("\xE3\x05\x07\x8D", 4));
+  cmux.poll();
+  CHECK_EQ(peer.frames.size(), before + 2);
+  CHECK(peer.frames[before + 1].data == std::string("\xE1\x05\x07\x8D", 4));
+}
+
+int main()
+{
+  RUN(testFcs);
+  RUN(testBegin);
+  RUN(testData);
+  RUN(testResync);
+  RUN(testUnreadChannel);
+  RUN(testHoldIgnored);
+  RUN(testModemRequests);
+  return testResult();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file       TestConnectStart.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * GsmClient::connectStart() and waitConnections(): sockets opened side by
+ * side, and a new connection that starts without the write error of the
+ * one before. Built once per driver, see DRIVER_TESTS in the Makefile.
+ */
+
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+
+// The n-th number after '=' in cmd, counting from 0
+static unsigned param(const char* cmd, int n)
+{
+  const char* p = strchr(cmd, '=');
+  while (p && n--) {
+    p = strchr(p + 1, ',');
+  }
+  return p ? (unsigned)atoi(p + 1) : 0;
+}
+
+/*
+ * Per-driver modem scripts: opens succeed, sends fail
+ */
+
+#if defined(TINY_GSM_MODEM_SIM800)
+
+static void script()
+{
+  fake.on("AT+CIPSTART=", [](FakeModem& m, const char* cmd) {
+    char buf[40];
+    sprintf(buf, "\r\nOK\r\n\r\n%u, CONNECT OK\r\n", param(cmd, 0));
+    m.reply(buf);
+  });
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+  fake.on("AT+CIPSEND=", "\r\nERROR\r\n");
+}
+
+#elif defined(TINY_GSM_MODEM_BG96)
+
+static void script()
+{
+  fake.on("AT+QIOPEN=", [](FakeModem& m, const char* cmd) {
+    char buf[40];
+    sprintf(buf, "\r\nOK\r\n\r\n+QIOPEN: %u,0\r\n", param(cmd, 1));
+    m.reply(buf);
+  });
+  fake.on("AT+QISEND=", "\r\nERROR\r\n");
+}
+
+#endif
+
+static void testOverlap()
+{
+  fake.reset();
+  fake.onUnknown("\r\nOK\r\n");
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient first(modem, 1);
+  TinyGsmClient second(modem, 2);
+  CHECK(first.connectStart("example.com", 80));
+  CHECK(second.connectStart("example.org", 80));
+  CHECK(modem.waitConnections(1000));
+  CHECK(!first.connecting());
+  CHECK(!second.connecting());
+  CHECK(first.connected());
+  CHECK(second.connected());
+}
+
+static void testWriteErrorCleared()
+{
+  fake.reset();
+  fake.onUnknown("\r\nOK\r\n");
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  CHECK(client.connect("example.com", 80));
+  client.write((const uint8_t*)"hello", 5);
+  client.flush();
+  CHECK(client.getWriteError());
+
+  CHECK(client.connectStart("example.com", 80));
+  CHECK_EQ(client.getWriteError(), 0);
+  CHECK(modem.waitConnections(1000));
+  CHECK(client.connected());
+}
+
+int main()
+{
+  RUN(testOverlap);
+  RUN(testWriteErrorCleared);
+  return testResult();
+}
@@ -0,0 +1,192 @@
+/**
+ * @file       TestConnections.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Socket states from the modem's status query: SIM800 (AT+CIPSTATUS) and
+ * BG96 (AT+QISTATE) refresh every socket with one query, UBLOX asks
+ * +USOCTL per socket. Built once per driver, see DRIVER_TESTS in the
+ * Makefile.
+ */
+
+#define TINY_GSM_SOCKET_WATCHDOG 200L
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+static bool open_[3];   // What the modem reports for sockets 0..2
+static int queries;     // Status queries sent
+
+// The n-th number after '=' in cmd, counting from 0
+static unsigned param(const char* cmd, int n)
+{
+  const char* p = strchr(cmd, '=');
+  while (p && n--) {
+    p = strchr(p + 1, ',');
+  }
+  return p ? (unsigned)atoi(p + 1) : 0;
+}
+
+/*
+ * Per-driver modem scripts, and refresh(), which makes the driver check
+ * the state of sockets 1 and 2 on its own
+ */
+
+#if defined(TINY_GSM_MODEM_SIM800)
+
+#define BULK_STATUS 1
+
+static void script()
+{
+  fake.on("AT+CIPSTART=", [](FakeModem& m, const char* cmd) {
+    char buf[40];
+    sprintf(buf, "\r\nOK\r\n\r\n%u, CONNECT OK\r\n", param(cmd, 0));
+    m.reply(buf);
+  });
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+  fake.on("AT+CIPRXGET=4,", [](FakeModem& m, const char* cmd) {
+    char buf[40];
+    sprintf(buf, "\r\n+CIPRXGET: 4,%u,0\r\n\r\nOK\r\n", param(cmd, 1));
+    m.reply(buf);
+  });
+  fake.on("AT+CIPSTATUS", [](FakeModem& m, const char* cmd) {
+    queries++;
+    m.reply("\r\nOK\r\n\r\nSTATE: IP PROCESSING\r\n\r\n");
+    for (int n = 0; n <= 5; n++) {
+      char buf[64];
+      if (n < 3 && open_[n]) {
+        sprintf(buf, "C: %d,0,\"TCP\",\"1.2.3.4\",\"80\",\"CONNECTED\"\r\n", n);
+      } else if (n == 1 || n == 2) {
+        sprintf(buf, "C: %d,0,\"TCP\",\"1.2.3.4\",\"80\",\"CLOSED\"\r\n", n);
+      } else {
+        sprintf(buf, "C: %d,,\"\",\"\",\"\",\"INITIAL\"\r\n", n);
+      }
+      m.reply(buf);
+    }
+  });
+}
+
+// The watchdog probes quiet sockets
+static void refresh(TinyGsm& modem)
+{
+  delay(TINY_GSM_SOCKET_WATCHDOG + 50);
+  modem.maintain();
+}
+
+#elif defined(TINY_GSM_MODEM_BG96)
+
+#define BULK_STATUS 1
+
+static void script()
+{
+  fake.on("AT+QIOPEN=", [](FakeModem& m, const char* cmd) {
+    char buf[40];
+    sprintf(buf, "\r\nOK\r\n\r\n+QIOPEN: %u,0\r\n", param(cmd, 1));
+    m.reply(buf);
+  });
+  fake.on("AT+QIRD=", "\r\n+QIRD: 5,5,0\r\n\r\nOK\r\n");
+  // Open sockets only; socket 2 is still listed while it closes
+  fake.on("AT+QISTATE", [](FakeModem& m, const char* cmd) {
+    queries++;
+    if (open_[1]) {
+      m.reply("\r\n+QISTATE: 1,\"TCP\",\"1.2.3.4\",80,5087,2,1,1,0,\"uart1\"\r\n");
+    }
+    m.reply(open_[2] ? "\r\n+QISTATE: 2,\"TCP\",\"1.2.3.4\",80,5088,2,1,2,0,\"uart1\"\r\n"
+                     : "\r\n+QISTATE: 2,\"TCP\",\"1.2.3.4\",80,5088,4,1,2,0,\"uart1\"\r\n");
+    m.reply("\r\nOK\r\n");
+  });
+}
+
+// Sockets that run dry after a notification are checked
+static void refresh(TinyGsm& modem)
+{
+  for (int n = 1; n <= 2; n++) {
+    char buf[40];
+    sprintf(buf, "\r\n+QIURC: \"recv\",%d\r\n", n);
+    fake.reply(buf);
+  }
+  modem.maintain();
+}
+
+#elif defined(TINY_GSM_MODEM_UBLOX)
+
+#define BULK_STATUS 0
+
+static unsigned created;
+
+static void script()
+{
+  created = 0;
+  fake.on("AT+USOCR=", [](FakeModem& m, const char* cmd) {
+    char buf[40];
+    sprintf(buf, "\r\n+USOCR: %u\r\n\r\nOK\r\n", ++created);
+    m.reply(buf);
+  });
+  fake.on("AT+USOCL=", "\r\nERROR\r\n");
+  fake.on("AT+USORD=", [](FakeModem& m, const char* cmd) {
+    char buf[40];
+    sprintf(buf, "\r\n+USORD: %u,0\r\n\r\nOK\r\n", param(cmd, 0));
+    m.reply(buf);
+  });
+  // 0 Inactive, 4 Established
+  fake.on("AT+USOCTL=", [](FakeModem& m, const char* cmd) {
+    char buf[40];
+    unsigned mux = param(cmd, 0);
+    queries++;
+    sprintf(buf, "\r\n+USOCTL: %u,10,%d\r\n\r\nOK\r\n", mux, mux < 3 && open_[mux] ? 4 : 0);
+    m.reply(buf);
+  });
+}
+
+// Sockets that run dry after a notification are checked
+static void refresh(TinyGsm& modem)
+{
+  for (int n = 1; n <= 2; n++) {
+    char buf[40];
+    sprintf(buf, "\r\n+UUSORD: %d,0\r\n", n);
+    fake.reply(buf);
+  }
+  modem.maintain();
+}
+
+#endif
+
+static void testRefresh()
+{
+  fake.reset();
+  fake.onUnknown("\r\nOK\r\n");
+  script();
+  open_[0] = false;
+  open_[1] = true;
+  open_[2] = true;
+  queries = 0;
+  TinyGsm modem(fake);
+  TinyGsmClient client1(modem, 1);
+  TinyGsmClient client2(modem, 2);
+  CHECK(client1.connect("example.com", 80));
+  CHECK(client2.connect("example.com", 80));
+
+  // Socket 2 was closed without a notification
+  open_[2] = false;
+  refresh(modem);
+  CHECK_EQ(queries, BULK_STATUS ? 1 : 2);
+  CHECK(client1.connected());
+  CHECK(!client2.connected());
+
+  // Then socket 1
+  open_[1] = false;
+  queries = 0;
+  refresh(modem);
+  CHECK_EQ(queries, BULK_STATUS ? 1 : 2);
+  CHECK(!client1.connected());
+  CHECK(!client2.connected());
+}
+
+int main()
+{
+  RUN(testRefresh);
+  return testResult();
+}
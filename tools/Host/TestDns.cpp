@@ -0,0 +1,133 @@
+/**
+ * @file       TestDns.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * TinyGsmDnsCache: expiry, eviction of the entry that expires first, and
+ * SIM800 connects that use it (plain ones only, SSL goes by name) and drop
+ * an address that could not be reached.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#define TINY_GSM_DNS_CACHE 2
+#define TINY_GSM_DNS_TTL 100
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+#include <string>
+
+static FakeModem fake;
+static std::string started;
+static bool refuse;
+
+static void script()
+{
+  fake.reset();
+  started.clear();
+  refuse = false;
+  fake.onUnknown("\r\nOK\r\n");
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+  fake.on("AT+CDNSGIP=", "\r\nOK\r\n\r\n+CDNSGIP: 1,\"example.com\",\"93.184.216.34\"\r\n");
+  fake.on("AT+CIPSTART=", [](FakeModem& m, const char* cmd) {
+    started = cmd;
+    m.reply(refuse ? "\r\nOK\r\n\r\n1, CONNECT FAIL\r\n" : "\r\nOK\r\n\r\n1, CONNECT OK\r\n");
+  });
+}
+
+static void testExpiry()
+{
+  TinyGsmDnsCache dns;
+  IPAddress ip;
+  CHECK(!dns.lookup("a.com", ip));
+  dns.store("a.com", IPAddress(1, 2, 3, 4));
+  CHECK(dns.lookup("a.com", ip));
+  CHECK_EQ(ip[3], 4);
+  delay(TINY_GSM_DNS_TTL + 20);
+  CHECK(!dns.lookup("a.com", ip));
+
+  // A new store starts the time over
+  dns.store("a.com", IPAddress(1, 2, 3, 4));
+  CHECK(dns.lookup("a.com", ip));
+  dns.remove("a.com");
+  CHECK(!dns.lookup("a.com", ip));
+}
+
+static void testEviction()
+{
+  TinyGsmDnsCache dns;
+  IPAddress ip;
+  dns.store("a.com", IPAddress(1, 0, 0, 1));
+  delay(5);
+  dns.store("b.com", IPAddress(1, 0, 0, 2));
+  delay(5);
+  dns.store("a.com", IPAddress(1, 0, 0, 3));  // Refreshed, b.com is older now
+  delay(5);
+  dns.store("c.com", IPAddress(1, 0, 0, 4));
+  CHECK(!dns.lookup("b.com", ip));
+  CHECK(dns.lookup("a.com", ip));
+  CHECK_EQ(ip[3], 3);
+  CHECK(dns.lookup("c.com", ip));
+  CHECK_EQ(ip[3], 4);
+
+  // Not kept: names that do not fit and addresses that are not
+  dns.store("d.com", IPAddress(0, 0, 0, 0));
+  CHECK(!dns.lookup("d.com", ip));
+  char name[TINY_GSM_DNS_HOST + 1];
+  memset(name, 'x', TINY_GSM_DNS_HOST);
+  name[TINY_GSM_DNS_HOST] = '\0';
+  dns.store(name, IPAddress(1, 0, 0, 5));
+  CHECK(!dns.lookup(name, ip));
+}
+
+// A plain connect goes to the cached address
+static void testConnectCached()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  IPAddress ip;
+  CHECK(modem.resolve("example.com", ip));
+  CHECK(client.connect("example.com", 80));
+  CHECK(started.find("\"93.184.216.34\"") != std::string::npos);
+}
+
+// A failed connect to the cached address drops it, the next goes by name
+static void testConnectCachedFails()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  IPAddress ip;
+  CHECK(modem.resolve("example.com", ip));
+  refuse = true;
+  CHECK(!client.connect("example.com", 80));
+  CHECK(started.find("\"93.184.216.34\"") != std::string::npos);
+  refuse = false;
+  CHECK(client.connect("example.com", 80));
+  CHECK(started.find("\"example.com\"") != std::string::npos);
+}
+
+// SSL connects pass the name, the modem needs it for SNI
+static void testConnectSecure()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClientSecure client(modem, 1);
+  IPAddress ip;
+  CHECK(modem.resolve("example.com", ip));
+  CHECK(client.connect("example.com", 443));
+  CHECK(started.find("\"example.com\"") != std::string::npos);
+}
+
+int main()
+{
+  RUN(testExpiry);
+  RUN(testEviction);
+  RUN(testConnectCached);
+  RUN(testConnectCachedFails);
+  RUN(testConnectSecure);
+  return testResult();
+}
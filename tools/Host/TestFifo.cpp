@@ -0,0 +1,217 @@
+/**
+ * @file       TestFifo.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * TinyGsmFifo, in both the power-of-two and the generic form: capacity,
+ * in-place spans across the wrap point. TinyGsmSpscFifo: full and empty
+ * states, index wrap, and a producer and a consumer thread working on it
+ * at the same time.
+ */
+
+#include "Arduino.h"
+#include <TinyGsmFifo.h>
+#include "HostTest.h"
+
+#include <thread>
+
+// Moves both indices of an empty fifo to `pos`
+template <class Fifo>
+static void moveTo(Fifo& f, int pos)
+{
+  uint8_t c;
+  for (int i = 0; i < pos; i++) {
+    f.put(0);
+    f.get(&c);
+  }
+}
+
+// Power of two: all N slots are used. Otherwise one stays empty
+template <unsigned N>
+static void checkCapacity(int cap)
+{
+  TinyGsmFifo<uint8_t, N> f;
+  uint8_t c = 0xFF;
+  CHECK(!f.readable());
+  CHECK(!f.get(&c));
+  CHECK_EQ(f.free(), cap);
+  for (int i = 0; i < cap; i++) {
+    CHECK(f.put((uint8_t)i));
+  }
+  CHECK_EQ(f.size(), cap);
+  CHECK_EQ(f.free(), 0);
+  CHECK(!f.writeable());
+  CHECK(!f.put(0));
+  for (int i = 0; i < cap; i++) {
+    CHECK(f.get(&c));
+    CHECK_EQ(c, i);
+  }
+  CHECK(!f.readable());
+
+  // The whole capacity in one span, at index 0
+  uint8_t* w;
+  const uint8_t* r;
+  f.clear();
+  CHECK_EQ(f.reserve(w), cap);
+  for (int i = 0; i < cap; i++) w[i] = i;
+  f.commit(cap);
+  CHECK_EQ(f.size(), cap);
+  CHECK_EQ(f.reserve(w), 0);
+  CHECK_EQ(f.peek(r), cap);
+  CHECK_EQ(r[cap - 1], cap - 1);
+  f.consume(cap);
+  CHECK(!f.readable());
+  CHECK_EQ(f.peek(r), 0);
+  CHECK_EQ(f.free(), cap);
+}
+
+// Spans stop at the end of the buffer, the rest comes from the start
+template <unsigned N>
+static void checkSpans(int cap)
+{
+  TinyGsmFifo<uint8_t, N> f;
+  const int start = N - 3;
+  uint8_t* w;
+  const uint8_t* r;
+  moveTo(f, start);
+
+  CHECK_EQ(f.reserve(w), 3);
+  w[0] = 0; w[1] = 1; w[2] = 2;
+  f.commit(3);
+  int rest = f.reserve(w);
+  CHECK_EQ(rest, cap - 3);
+  for (int i = 0; i < rest; i++) w[i] = 3 + i;
+  f.commit(rest);
+  CHECK_EQ(f.size(), cap);
+  CHECK_EQ(f.free(), 0);
+
+  // peek() only returns the run up to the wrap
+  CHECK_EQ(f.peek(r), 3);
+  CHECK_EQ(r[0], 0);
+  CHECK_EQ(r[2], 2);
+  f.consume(3);
+  CHECK_EQ(f.peek(r), rest);
+  CHECK_EQ(r[0], 3);
+  CHECK_EQ(r[rest - 1], cap - 1);
+  f.consume(rest);
+  CHECK(!f.readable());
+
+  // Copies across the wrap keep the order
+  uint8_t in[6] = { 10, 11, 12, 13, 14, 15 };
+  uint8_t out[6] = { 0 };
+  CHECK_EQ(f.put(in, 6), 6);
+  CHECK_EQ(f.get(out, 6), 6);
+  CHECK(!memcmp(in, out, 6));
+}
+
+static void testFifoPow2()
+{
+  checkCapacity<8>(8);
+  checkSpans<8>(8);
+}
+
+static void testFifoGeneric()
+{
+  checkCapacity<7>(6);
+  checkSpans<7>(6);
+}
+
+// One slot stays empty, so it holds N-1
+static void testSpscFullEmpty()
+{
+  TinyGsmSpscFifo<uint8_t, 8> f;
+  uint8_t c = 0xFF;
+  CHECK(!f.readable());
+  CHECK_EQ(f.size(), 0);
+  CHECK_EQ(f.free(), 7);
+  CHECK(!f.get(&c));
+  for (int i = 0; i < 7; i++) {
+    CHECK(f.put((uint8_t)i));
+  }
+  CHECK_EQ(f.size(), 7);
+  CHECK_EQ(f.free(), 0);
+  CHECK(!f.writeable());
+  CHECK(!f.put(7));
+  for (int i = 0; i < 7; i++) {
+    CHECK(f.get(&c));
+    CHECK_EQ(c, i);
+  }
+  CHECK(!f.readable());
+  CHECK_EQ(f.free(), 7);
+}
+
+// The indices go around the buffer many times
+static void testSpscWrap()
+{
+  TinyGsmSpscFifo<uint8_t, 8> f;
+  uint8_t in[5], out[5];
+  uint8_t next = 0, expect = 0;
+  int bad = 0;
+  for (int round = 0; round < 50; round++) {
+    for (int i = 0; i < 5; i++) in[i] = next++;
+    CHECK_EQ(f.put(in, 5), 5);
+    CHECK_EQ(f.size(), 5);
+    CHECK_EQ(f.get(out, 5), 5);
+    for (int i = 0; i < 5; i++) {
+      if (out[i] != expect++) bad++;
+    }
+  }
+  CHECK_EQ(bad, 0);
+
+  // A copy that does not fit stops at N-1
+  uint8_t big[10] = { 0 };
+  CHECK_EQ(f.put(big, 10), 7);
+  CHECK_EQ(f.get(big, 10), 7);
+  CHECK(!f.readable());
+}
+
+// One thread writes a counting sequence, the other checks it
+static void testSpscThreads()
+{
+  static TinyGsmSpscFifo<uint8_t, 61> f;
+  const unsigned long total = 200000;
+  unsigned long bad = 0;
+
+  std::thread producer([&]() {
+    uint8_t next = 0;
+    unsigned long sent = 0;
+    while (sent < total) {
+      uint8_t* p;
+      int n = f.reserve(p);
+      if (!n) delay(0);  // Full, let the consumer run
+      if ((unsigned long)n > total - sent) n = total - sent;
+      for (int i = 0; i < n; i++) p[i] = next++;
+      f.commit(n);
+      sent += n;
+    }
+  });
+
+  uint8_t expect = 0;
+  unsigned long got = 0;
+  while (got < total) {
+    const uint8_t* p;
+    int n = f.peek(p);
+    if (!n) delay(0);  // Empty, let the producer run
+    for (int i = 0; i < n; i++) {
+      if (p[i] != expect++) bad++;
+    }
+    f.consume(n);
+    got += n;
+  }
+  producer.join();
+  CHECK_EQ(bad, 0);
+  CHECK_EQ(got, total);
+  CHECK(!f.readable());
+}
+
+int main()
+{
+  RUN(testFifoPow2);
+  RUN(testFifoGeneric);
+  RUN(testSpscFullEmpty);
+  RUN(testSpscWrap);
+  RUN(testSpscThreads);
+  return testResult();
+}
@@ -0,0 +1,115 @@
+/**
+ * @file       TestHex.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Hex decoding: the block (SSE2) path against the table, and hex payloads
+ * that arrive split in the middle of a byte.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#include <TinyGsmClient.h>
+#include "HostTest.h"
+
+// What the table says, one digit at a time
+static uint8_t reference(char hi, char lo)
+{
+  return (TinyGsmHexValue(hi) << 4) | TinyGsmHexValue(lo);
+}
+
+static void testTable()
+{
+  CHECK_EQ(TinyGsmHexValue('0'), 0);
+  CHECK_EQ(TinyGsmHexValue('9'), 9);
+  CHECK_EQ(TinyGsmHexValue('A'), 10);
+  CHECK_EQ(TinyGsmHexValue('f'), 15);
+  CHECK_EQ(TinyGsmHexValue('g'), 0);
+  CHECK_EQ(TinyGsmHexValue('/'), 0);
+  CHECK_EQ(TinyGsmHexValue((char)0xB0), 0);
+}
+
+// Every byte value in every digit position of a block, valid or not
+static void testBlocks()
+{
+  char src[32];
+  uint8_t dst[16];
+  int bad = 0;
+  for (int c = 0; c < 256; c++) {
+    for (int pos = 0; pos < 32; pos++) {
+      for (int i = 0; i < 32; i++) src[i] = "0123456789abcdefABCDEF"[(i * 7 + c) % 22];
+      src[pos] = (char)c;
+      TinyGsmHexDecode(dst, src, 16);
+      for (int i = 0; i < 16; i++) {
+        if (dst[i] != reference(src[i * 2], src[i * 2 + 1])) bad++;
+      }
+    }
+  }
+  CHECK_EQ(bad, 0);
+}
+
+// Lengths around the block size, and decoding in place
+static void testLengths()
+{
+  for (size_t n = 0; n <= 40; n++) {
+    char src[81];
+    uint8_t dst[40];
+    for (size_t i = 0; i < n; i++) sprintf(src + i * 2, "%02X", (unsigned)(i * 37 + n) & 0xFF);
+    TinyGsmHexDecode(dst, src, n);
+    bool ok = true;
+    for (size_t i = 0; i < n; i++) ok &= dst[i] == ((i * 37 + n) & 0xFF);
+    CHECK(ok);
+    TinyGsmHexDecode((uint8_t*)src, src, n);
+    CHECK(!memcmp(src, dst, n));
+  }
+}
+
+// Hands out at most `step` bytes per readBytes(), like a stream that timed out
+class ChoppyStream : public Stream
+{
+public:
+  ChoppyStream(const char* text, size_t step) : text(text), pos(0), step(step) {}
+
+  virtual int available() { return strlen(text + pos); }
+  virtual int read() { return text[pos] ? text[pos++] : -1; }
+  virtual int peek() { return text[pos] ? text[pos] : -1; }
+  virtual size_t write(uint8_t) { return 1; }
+  virtual size_t readBytes(char* buffer, size_t length) {
+    size_t n = TinyGsmMin(TinyGsmMin(length, step), strlen(text + pos));
+    memcpy(buffer, text + pos, n);
+    pos += n;
+    return n;
+  }
+  using Print::write;
+  using Stream::readBytes;
+
+  const char* text;
+  size_t      pos;
+  size_t      step;
+};
+
+// A read that times out between the two digits of a byte must not leave
+// the second digit in the stream, where it would shift all later bytes
+static void testSplitPayload()
+{
+  const char* hex = "48656C6C6F2C20776F726C6421";  // "Hello, world!"
+  for (size_t step = 1; step <= 5; step++) {
+    ChoppyStream stream(hex, step);
+    TinyGsmFifo<uint8_t, 64> rx;
+    uint8_t buf[13];
+    size_t got = TinyGsmReadPayload(stream, rx, 13, buf, sizeof(buf), true);
+    CHECK_EQ(got, (step + 1) / 2);
+    CHECK_EQ(stream.pos, got * 2);
+    CHECK(!memcmp(buf, "Hello, world!", got));
+  }
+}
+
+int main()
+{
+  RUN(testTable);
+  RUN(testBlocks);
+  RUN(testLengths);
+  RUN(testSplitPayload);
+  return testResult();
+}
@@ -0,0 +1,85 @@
+/**
+ * @file       TestMatcher.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * TinyGsmMatcher ties: equal patterns, patterns that are suffixes of
+ * others, and patterns that did not fit into the automaton.
+ */
+
+// Small, so the spill cases below do not fit
+#define TINY_GSM_MATCHER_NODES 16
+#include <TinyGsmCommon.h>
+#include "HostTest.h"
+
+// Id of the first pattern text ends, like waitResponse() takes it
+static uint8_t match(TinyGsmMatcher& m, const char* text)
+{
+  TinyGsmResponse data;
+  m.restart();
+  for (const char* p = text; *p; p++) {
+    data.push(*p);
+    uint8_t id = m.feed(data);
+    if (id) return id;
+  }
+  return 0;
+}
+
+// Equal patterns go to the lowest id, so a response beats a URC
+static void testEqual()
+{
+  static const GsmConstStr urcs[] = { GF("OK\r\n") };
+  TinyGsmMatcher m;
+  m.load(GF("ERROR\r\n"), GF("OK\r\n"), GF("OK\r\n"), NULL, NULL, urcs, 1);
+  CHECK_EQ(match(m, "\r\nOK\r\n"), 2);
+  CHECK_EQ(match(m, "\r\nERROR\r\n"), 1);
+  CHECK_EQ(match(m, "\r\nNO CARRIER\r\n"), 0);
+}
+
+// The longest pattern ending on a byte wins
+static void testSuffix()
+{
+  static const GsmConstStr urcs[] = { GF("CLOSE OK\r\n"), GF("CLOSED\r\n") };
+  TinyGsmMatcher m;
+  m.load(GF("OK\r\n"), GF("ERROR\r\n"), NULL, NULL, NULL, urcs, 2);
+  CHECK_EQ(match(m, "\r\n1, CLOSE OK\r\n"), 6);
+  CHECK_EQ(match(m, "\r\n1, CLOSED\r\n"), 7);
+  CHECK_EQ(match(m, "\r\nOK\r\n"), 1);
+  // Through a failure link: "CLOSE " leads nowhere, "OK" starts over
+  CHECK_EQ(match(m, "CLOSE CLOSE OK\r\n"), 6);
+  CHECK_EQ(match(m, "NOT CLOSE\r\nOK\r\n"), 1);
+}
+
+// Spilled patterns are matched with endsWith(), under the same rules
+static void testSpill()
+{
+  // 13 of the 15 free nodes, "OK\r\n" does not fit
+  TinyGsmMatcher a;
+  a.load(GF("1, CLOSE OK\r\n"), GF("OK\r\n"), NULL, NULL, NULL);
+  CHECK_EQ(match(a, "\r\n1, CLOSE OK\r\n"), 1);
+  CHECK_EQ(match(a, "\r\nOK\r\n"), 2);
+
+  // The longer spilled pattern beats the shorter one in the automaton
+  static const GsmConstStr urcs[] = { GF("CONNECT OK\r\n") };
+  TinyGsmMatcher b;
+  b.load(GF("ERROR\r\n"), GF("OK\r\n"), NULL, NULL, NULL, urcs, 1);
+  CHECK_EQ(match(b, "\r\n1, CONNECT OK\r\n"), 6);
+  CHECK_EQ(match(b, "\r\nOK\r\n"), 2);
+
+  // Equal spilled patterns go to the lowest id as well
+  static const GsmConstStr same[] = { GF("SEND OK\r\n") };
+  TinyGsmMatcher c;
+  c.load(GF("ERROR\r\n"), GF("SEND OK\r\n"), NULL, NULL, NULL, same, 1);
+  CHECK_EQ(match(c, "\r\n1, SEND OK\r\n"), 2);
+  CHECK_EQ(match(c, "\r\nERROR\r\n"), 1);
+}
+
+int main()
+{
+  RUN(testEqual);
+  RUN(testSuffix);
+  RUN(testSpill);
+  return testResult();
+}
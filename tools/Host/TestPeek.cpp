@@ -0,0 +1,162 @@
+/**
+ * @file       TestPeek.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * GsmClient::peek(): fetches data the modem announced, returns the next
+ * byte without taking it, and costs no command while data is buffered.
+ * Built once per driver, see Peek_MODEMS in the Makefile.
+ */
+
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+
+/*
+ * Per-driver modem scripts: connect socket 1, then announce() "hello"
+ */
+
+#if defined(TINY_GSM_MODEM_SIM800)
+
+static void script()
+{
+  fake.on("AT+CIPSTART=", "\r\nOK\r\n\r\n1, CONNECT OK\r\n");
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+  fake.on("AT+CIPRXGET=4,1", "\r\n+CIPRXGET: 4,1,5\r\n\r\nOK\r\n");
+  fake.on("AT+CIPRXGET=2,1,", "\r\n+CIPRXGET: 2,1,5,0\r\nhello\r\nOK\r\n");
+}
+
+static void announce()
+{
+  fake.reply("\r\n+CIPRXGET: 1,1\r\n");
+}
+
+#elif defined(TINY_GSM_MODEM_BG96)
+
+static void script()
+{
+  fake.on("AT+QIOPEN=", "\r\nOK\r\n\r\n+QIOPEN: 1,0\r\n");
+  fake.on("AT+QIRD=1,0", "\r\n+QIRD: 5,0,5\r\n\r\nOK\r\n");
+  fake.on("AT+QIRD=1,", "\r\n+QIRD: 5\r\nhello\r\n\r\nOK\r\n");
+}
+
+static void announce()
+{
+  fake.reply("\r\n+QIURC: \"recv\",1\r\n");
+}
+
+#elif defined(TINY_GSM_MODEM_UBLOX)
+
+static void script()
+{
+  fake.on("AT+USOCR=", "\r\n+USOCR: 1\r\n\r\nOK\r\n");
+  fake.on("AT+USOCL=", "\r\nERROR\r\n");
+  fake.on("AT+USORD=1,0", "\r\n+USORD: 1,5\r\n\r\nOK\r\n");
+  fake.on("AT+USORD=1,", "\r\n+USORD: 1,5,\"hello\"\r\n\r\nOK\r\n");
+}
+
+static void announce()
+{
+  fake.reply("\r\n+UUSORD: 1,5\r\n");
+}
+
+#elif defined(TINY_GSM_MODEM_ESP8266)
+
+static void script()
+{
+  fake.on("AT+CIPSTART=", "1,CONNECT\r\n\r\nOK\r\n");
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+}
+
+// Pushed with the notification
+static void announce()
+{
+  fake.reply("\r\n+IPD,1,5:hello");
+}
+
+#elif defined(TINY_GSM_MODEM_A6)
+
+// The modem picks the socket, see +CIPNUM
+#define SOCKET
+
+static void script()
+{
+  fake.on("AT+CIPSTART=", "\r\n+CIPNUM:1\r\n\r\nCONNECT OK\r\n\r\nOK\r\n");
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+}
+
+static void announce()
+{
+  fake.reply("\r\n+CIPRCV:1,5,hello");
+}
+
+#elif defined(TINY_GSM_MODEM_M590)
+
+static void script()
+{
+  fake.on("AT+DNS=", "\r\nOK\r\n\r\n+DNS:1.2.3.4\r\n+DNS:OK\r\n");
+  fake.on("AT+TCPSETUP=", "\r\n+TCPSETUP:1,OK\r\n");
+  fake.on("AT+TCPCLOSE=", "\r\nERROR\r\n");
+}
+
+static void announce()
+{
+  fake.reply("\r\n+TCPRECV:1,5,hello\r\n");
+}
+
+#endif
+
+#if !defined(SOCKET)
+#define SOCKET , 1
+#endif
+
+static void testPeek()
+{
+  fake.reset();
+  fake.onUnknown("\r\nOK\r\n");
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem SOCKET);
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(client.peek(), -1);
+
+  announce();
+  CHECK_EQ(client.peek(), 'h');
+  unsigned long sent = fake.commands();
+  CHECK_EQ(client.peek(), 'h');
+  CHECK_EQ(fake.commands(), sent);
+  CHECK_EQ(client.available(), 5);
+
+  CHECK_EQ(client.read(), 'h');
+  CHECK_EQ(client.peek(), 'e');
+  char buf[8] = { 0 };
+  CHECK_EQ(client.read((uint8_t*)buf, 4), 4);
+  CHECK_STR(buf, "ello");
+  CHECK_EQ(client.peek(), -1);
+}
+
+// Stream::find() and friends work on top of peek()
+static void testFind()
+{
+  fake.reset();
+  fake.onUnknown("\r\nOK\r\n");
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem SOCKET);
+  CHECK(client.connect("example.com", 80));
+  announce();
+  client.setTimeout(100);
+  CHECK(client.find((char*)"ll"));
+  CHECK_EQ(client.peek(), 'o');
+}
+
+int main()
+{
+  RUN(testPeek);
+  RUN(testFind);
+  return testResult();
+}
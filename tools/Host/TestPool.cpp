@@ -0,0 +1,159 @@
+/**
+ * @file       TestPool.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * TinyGsmPool on SIM800: reuse of idle connections, eviction of the one
+ * idle for the longest time, release with unread data or after a failed
+ * write, and idle connections the remote end closed.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#define TINY_GSM_POOL_SIZE 2
+#include <TinyGsmClient.h>
+#include <TinyGsmPool.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+static int opened[TINY_GSM_MUX_COUNT];
+static int closed[TINY_GSM_MUX_COUNT];
+static bool live[TINY_GSM_MUX_COUNT];
+static int unread[TINY_GSM_MUX_COUNT];
+
+static void script()
+{
+  fake.reset();
+  memset(opened, 0, sizeof(opened));
+  memset(closed, 0, sizeof(closed));
+  memset(unread, 0, sizeof(unread));
+  memset(live, 0, sizeof(live));
+  fake.onUnknown("\r\nOK\r\n");
+  fake.on("AT+CIPSTART=", [](FakeModem& m, const char* cmd) {
+    int mux = cmd[12] - '0';
+    opened[mux]++;
+    live[mux] = true;
+    m.reply(String("\r\nOK\r\n\r\n") + mux + ", CONNECT OK\r\n");
+  });
+  fake.on("AT+CIPCLOSE=", [](FakeModem& m, const char* cmd) {
+    int mux = cmd[12] - '0';
+    if (!live[mux]) {
+      m.reply("\r\nERROR\r\n");
+      return;
+    }
+    live[mux] = false;
+    closed[mux]++;
+    m.reply(String("\r\n") + mux + ", CLOSE OK\r\n");
+  });
+  fake.on("AT+CIPRXGET=4,", [](FakeModem& m, const char* cmd) {
+    int mux = cmd[14] - '0';
+    m.reply(String("\r\n+CIPRXGET: 4,") + mux + "," + unread[mux] + "\r\n\r\nOK\r\n");
+  });
+  fake.on("AT+CIPSEND=", "\r\nERROR\r\n");
+}
+
+static int sum(const int* counts)
+{
+  int n = 0;
+  for (int i = 0; i < TINY_GSM_MUX_COUNT; i++) n += counts[i];
+  return n;
+}
+
+static void testReuse()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmPool<TinyGsm> pool(modem);
+  CHECK_EQ(pool.size(), 2);
+  TinyGsmClient* a = pool.acquire("example.com", 80);
+  CHECK(a != NULL);
+  pool.release(a);
+  CHECK(pool.acquire("example.com", 80) == a);
+  CHECK_EQ(sum(opened), 1);
+  CHECK_EQ(sum(closed), 0);
+
+  // Busy, so another endpoint gets the other socket
+  TinyGsmClient* b = pool.acquire("example.com", 443);
+  CHECK(b != NULL && b != a);
+  CHECK(pool.acquire("example.org", 80) == NULL);
+}
+
+static void testEvictLongestIdle()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmPool<TinyGsm> pool(modem);
+  TinyGsmClient* a = pool.acquire("a.example.com", 80);
+  TinyGsmClient* b = pool.acquire("b.example.com", 80);
+  pool.release(a);
+  delay(5);
+  pool.release(b);
+
+  TinyGsmClient* c = pool.acquire("c.example.com", 80);
+  CHECK(c == a);
+  CHECK_EQ(sum(closed), 1);
+  CHECK(pool.acquire("b.example.com", 80) == b);
+  CHECK_EQ(sum(opened), 3);
+}
+
+// Data the next user would get is not handed on
+static void testReleaseUnread()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmPool<TinyGsm> pool(modem);
+  TinyGsmClient* a = pool.acquire("example.com", 80);
+  unread[0] = 5;
+  fake.reply("\r\n+CIPRXGET: 1,0\r\n");
+  pool.release(a);
+  CHECK_EQ(closed[0], 1);
+  unread[0] = 0;
+  CHECK(pool.acquire("example.com", 80) != NULL);
+  CHECK_EQ(sum(opened), 2);
+}
+
+// A connection whose send failed is not handed on, nor its write error
+static void testReleaseWriteError()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmPool<TinyGsm> pool(modem);
+  TinyGsmClient* a = pool.acquire("example.com", 80);
+  a->write((const uint8_t*)"hello", 5);
+  a->flush();
+  CHECK(a->getWriteError());
+  pool.release(a);
+  CHECK_EQ(closed[0], 1);
+  CHECK(pool.acquire("example.com", 80) == a);
+  CHECK_EQ(sum(opened), 2);
+  CHECK_EQ(a->getWriteError(), 0);
+}
+
+// An idle connection the remote end closed is opened again
+static void testClosedWhileIdle()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmPool<TinyGsm> pool(modem);
+  TinyGsmClient* a = pool.acquire("example.com", 80);
+  pool.release(a);
+  live[0] = false;
+  fake.reply("\r\n0, CLOSED\r\n");
+  modem.maintain();
+  CHECK(!a->connected());
+  CHECK(pool.acquire("example.com", 80) == a);
+  CHECK_EQ(opened[0], 2);
+  CHECK(a->connected());
+}
+
+int main()
+{
+  RUN(testReuse);
+  RUN(testEvictLongestIdle);
+  RUN(testReleaseUnread);
+  RUN(testReleaseWriteError);
+  RUN(testClosedWhileIdle);
+  return testResult();
+}
@@ -0,0 +1,126 @@
+/**
+ * @file       TestQueue.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Queued AT commands (queueAT()): priority order, commands queued while
+ * another is in flight, and socket reads in between.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+#include <string>
+
+// Longer than TINY_GSM_ASYNC_SLICE, so it takes more than one poll
+#define LONG_ANSWER \
+  "SIMCOM_Ltd SIMCOM_SIM800 Revision:1418B04SIM800L24 " \
+  "Copyright (c) 2016 Volodymyr Shymanskyy"
+
+static FakeModem fake;
+
+static void script()
+{
+  fake.reset();
+  fake.onUnknown("\r\nOK\r\n");
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+  fake.on("AT+CIPSTART=", "\r\nOK\r\n\r\n1, CONNECT OK\r\n");
+  fake.on("AT+CIPRXGET=4,1", "\r\n+CIPRXGET: 4,1,5\r\n\r\nOK\r\n");
+  fake.on("AT+CIPRXGET=2,1,", "\r\n+CIPRXGET: 2,1,5,0\r\nhello\r\nOK\r\n");
+  fake.on("AT+CGMI", "\r\n" LONG_ANSWER "\r\n\r\nOK\r\n");
+  fake.on("AT+CSQ", "\r\n+CSQ: 20,0\r\n\r\nOK\r\n");
+}
+
+struct Answer
+{
+  uint8_t     index;
+  std::string data;
+};
+
+static void onAnswer(void* arg, uint8_t index, TinyGsmResponse& data)
+{
+  Answer* a = static_cast<Answer*>(arg);
+  a->index = index;
+  a->data = data.c_str();
+}
+
+static void run(TinyGsm& modem)
+{
+  for (int i = 0; i < 20 && modem.queuedAT(); i++) {
+    modem.maintain();
+  }
+}
+
+static void testOrder()
+{
+  TinyGsmCommandQueue q;
+  q.insert(0)->arg = (void*)1;
+  q.insert(0)->arg = (void*)2;
+  q.insert(5)->arg = (void*)3;
+  CHECK_EQ(q.size(), 3);
+  CHECK(q.front().arg == (void*)3);
+  q.pop();
+  CHECK(q.front().arg == (void*)1);
+
+  // Once sent, the front stays where it is
+  q.sent();
+  q.insert(9)->arg = (void*)4;
+  CHECK(q.front().arg == (void*)1);
+  q.pop();
+  CHECK(q.front().arg == (void*)4);
+  q.pop();
+  CHECK(q.front().arg == (void*)2);
+  q.pop();
+  CHECK(q.empty());
+}
+
+// A higher priority command queued while another one is in flight
+static void testInsertInFlight()
+{
+  script();
+  TinyGsm modem(fake);
+  Answer low = { 0xFF, "" };
+  Answer high = { 0xFF, "" };
+  CHECK(modem.queueAT("+CGMI", onAnswer, &low));
+  modem.maintain();
+  CHECK_EQ(modem.queuedAT(), 1);
+  CHECK(modem.queueAT("+CSQ", onAnswer, &high, 10));
+  run(modem);
+  CHECK_EQ(modem.queuedAT(), 0);
+  CHECK_EQ(low.index, 1);
+  CHECK(low.data.find("SIMCOM_SIM800") != std::string::npos);
+  CHECK_EQ(high.index, 1);
+  CHECK(high.data.find("+CSQ: 20,0") != std::string::npos);
+}
+
+// A socket read while a queued command is in flight waits for its answer
+static void testReadInFlight()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  CHECK(client.connect("example.com", 80));
+  fake.reply("\r\n+CIPRXGET: 1,1\r\n");
+  modem.maintain();
+
+  Answer a = { 0xFF, "" };
+  CHECK(modem.queueAT("+CGMI", onAnswer, &a));
+  char buf[8] = { 0 };
+  CHECK_EQ(client.read((uint8_t*)buf, 5), 5);
+  CHECK_STR(buf, "hello");
+  run(modem);
+  CHECK_EQ(a.index, 1);
+  CHECK(a.data.find("SIMCOM_SIM800") != std::string::npos);
+}
+
+int main()
+{
+  RUN(testOrder);
+  RUN(testInsertInFlight);
+  RUN(testReadInFlight);
+  return testResult();
+}
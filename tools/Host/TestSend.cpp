@@ -0,0 +1,116 @@
+/**
+ * @file       TestSend.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * SIM800 sends: quick send mode, the fallback to waiting for every send
+ * when the modem refuses that mode, and send failures reaching the
+ * client's write error.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+static std::string sent;
+static bool quick;
+static bool fail;
+
+static void script()
+{
+  fake.reset();
+  sent.clear();
+  fail = false;
+  fake.onUnknown("\r\nOK\r\n");
+  fake.on("AT+CIPQSEND?", [](FakeModem& m, const char* cmd) {
+    m.reply(quick ? "\r\n+CIPQSEND: 1\r\n\r\nOK\r\n" : "\r\n+CIPQSEND: 0\r\n\r\nOK\r\n");
+  });
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+  fake.on("AT+CIPSTART=", "\r\nOK\r\n\r\n1, CONNECT OK\r\n");
+  fake.on("AT+CIPSEND=", [](FakeModem& m, const char* cmd) {
+    unsigned mux, len;
+    sscanf(cmd, "AT+CIPSEND=%u,%u", &mux, &len);
+    m.reply("> ");
+    m.receiveData(len, [mux](FakeModem& m, const uint8_t* data, size_t len) {
+      char buf[40];
+      sent.append((const char*)data, len);
+      if (fail) {
+        sprintf(buf, "\r\n%u, SEND FAIL\r\n", mux);
+      } else if (quick) {
+        sprintf(buf, "\r\nDATA ACCEPT:%u,%u\r\n", mux, (unsigned)len);
+      } else {
+        sprintf(buf, "\r\n%u, SEND OK\r\n", mux);
+      }
+      m.reply(buf);
+    });
+  });
+}
+
+static void testQuickSend()
+{
+  quick = true;
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  CHECK(modem.gprsConnect("internet"));
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(client.write((const uint8_t*)"hello", 5), 5);
+  client.flush();
+  CHECK_STR(sent.c_str(), "hello");
+  CHECK_EQ(client.getWriteError(), 0);
+}
+
+// Without quick send there is no DATA ACCEPT, every send waits for SEND OK
+static void testNoQuickSend()
+{
+  quick = false;
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  CHECK(modem.gprsConnect("internet"));
+  CHECK(client.connect("example.com", 80));
+  unsigned long start = millis();
+  CHECK_EQ(client.write((const uint8_t*)"hello", 5), 5);
+  client.flush();
+  CHECK(millis() - start < 1000);
+  CHECK_STR(sent.c_str(), "hello");
+  CHECK_EQ(client.getWriteError(), 0);
+
+  fail = true;
+  CHECK_EQ(client.write((const uint8_t*)"again", 5), 5);
+  client.flush();
+  CHECK(client.getWriteError() != 0);
+}
+
+// A quick send is reported as written at once, its SEND FAIL comes later
+static void testQuickSendFails()
+{
+  quick = true;
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  CHECK(modem.gprsConnect("internet"));
+  CHECK(client.connect("example.com", 80));
+  fail = true;
+  CHECK_EQ(client.write((const uint8_t*)"hello", 5), 5);
+  client.available();
+  modem.maintain();
+  CHECK(client.getWriteError() != 0);
+  CHECK_EQ(client.write((const uint8_t*)"more", 4), 0);
+
+  fail = false;
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(client.getWriteError(), 0);
+}
+
+int main()
+{
+  RUN(testQuickSend);
+  RUN(testNoQuickSend);
+  RUN(testQuickSendFails);
+  return testResult();
+}
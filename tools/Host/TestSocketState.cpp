@@ -0,0 +1,139 @@
+/**
+ * @file       TestSocketState.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * SIM800 socket state from URCs: +CIPRXGET: 1 and "<n>, CLOSED" update a
+ * socket without polling, and only a socket that stayed quiet for
+ * TINY_GSM_SOCKET_WATCHDOG is probed with AT+CIPSTATUS.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#define TINY_GSM_SOCKET_WATCHDOG 200L
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+static int polls;     // AT+CIPRXGET=4
+static int probes;    // AT+CIPSTATUS of all sockets
+static bool open1;    // What +CIPSTATUS reports for socket 1
+
+static void script()
+{
+  fake.reset();
+  polls = 0;
+  probes = 0;
+  open1 = true;
+  fake.onUnknown("\r\nOK\r\n");
+  fake.on("AT+CIPSTART=", "\r\nOK\r\n\r\n1, CONNECT OK\r\n");
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+  fake.on("AT+CIPRXGET=4,1", [](FakeModem& m, const char* cmd) {
+    polls++;
+    m.reply("\r\n+CIPRXGET: 4,1,5\r\n\r\nOK\r\n");
+  });
+  fake.on("AT+CIPRXGET=2,1,", "\r\n+CIPRXGET: 2,1,5,0\r\nhello\r\nOK\r\n");
+  fake.on("AT+CIPSTATUS", [](FakeModem& m, const char* cmd) {
+    probes++;
+    m.reply("\r\nOK\r\n\r\nSTATE: IP PROCESSING\r\n\r\n"
+            "C: 0,,\"\",\"\",\"\",\"INITIAL\"\r\n");
+    m.reply(open1 ? "C: 1,0,\"TCP\",\"1.2.3.4\",\"80\",\"CONNECTED\"\r\n"
+                  : "C: 1,0,\"TCP\",\"1.2.3.4\",\"80\",\"CLOSED\"\r\n");
+    m.reply("C: 2,,\"\",\"\",\"\",\"INITIAL\"\r\n"
+            "C: 3,,\"\",\"\",\"\",\"INITIAL\"\r\n"
+            "C: 4,,\"\",\"\",\"\",\"INITIAL\"\r\n"
+            "C: 5,,\"\",\"\",\"\",\"INITIAL\"\r\n");
+  });
+}
+
+// A quiet socket costs no command until the watchdog is due
+static void testIdle()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  CHECK(client.connect("example.com", 80));
+  unsigned long sent = fake.commands();
+  for (int i = 0; i < 10; i++) {
+    modem.maintain();
+    CHECK_EQ(client.available(), 0);
+    CHECK(client.connected());
+  }
+  CHECK_EQ(fake.commands(), sent);
+}
+
+// +CIPRXGET: 1 is answered with one size query
+static void testDataUrc()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  CHECK(client.connect("example.com", 80));
+  fake.reply("\r\n+CIPRXGET: 1,1\r\n");
+  CHECK_EQ(client.available(), 5);
+  CHECK_EQ(polls, 1);
+  modem.maintain();
+  CHECK_EQ(client.available(), 5);
+  CHECK_EQ(polls, 1);
+  CHECK_EQ(probes, 0);
+}
+
+// "<n>, CLOSED" ends the socket without a status query
+static void testClosedUrc()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  TinyGsmClient other(modem, 2);
+  CHECK(client.connect("example.com", 80));
+  unsigned long sent = fake.commands();
+  fake.reply("\r\n1, CLOSED\r\n");
+  modem.maintain();
+  CHECK(!client.connected());
+  CHECK(!other.connected());
+  CHECK_EQ(fake.commands(), sent);
+}
+
+// After the watchdog period one AT+CIPSTATUS checks every socket
+static void testWatchdog()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  CHECK(client.connect("example.com", 80));
+  delay(TINY_GSM_SOCKET_WATCHDOG + 50);
+  modem.maintain();
+  CHECK_EQ(probes, 1);
+  CHECK_EQ(polls, 1);
+  CHECK(client.connected());
+  CHECK_EQ(client.available(), 5);
+
+  // Probed just now, so quiet again
+  modem.maintain();
+  CHECK_EQ(probes, 1);
+
+  char buf[8] = { 0 };
+  CHECK_EQ(client.read((uint8_t*)buf, 5), 5);
+  CHECK_STR(buf, "hello");
+
+  // A close the modem did not announce
+  open1 = false;
+  delay(TINY_GSM_SOCKET_WATCHDOG + 50);
+  modem.maintain();
+  CHECK_EQ(probes, 2);
+  CHECK_EQ(polls, 1);
+  CHECK(!client.connected());
+  modem.maintain();
+  CHECK_EQ(probes, 2);
+}
+
+int main()
+{
+  RUN(testIdle);
+  RUN(testDataUrc);
+  RUN(testClosedUrc);
+  RUN(testWatchdog);
+  return testResult();
+}
@@ -0,0 +1,139 @@
+/**
+ * @file       TestStats.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * TinyGsmStats: command names, latency, percentiles and the table limit,
+ * and the counts SIM800 keeps with TINY_GSM_STATS for commands, errors,
+ * timeouts and socket bytes.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#define TINY_GSM_STATS
+#define TINY_GSM_STATS_COMMANDS 8
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+
+static void testNames()
+{
+  TinyGsmStats stats;
+  stats.sent("+CIPSEND=1,5");
+  stats.received(1, false);
+  stats.sent("+CIPSTATUS?");
+  stats.received(1, false);
+  stats.sent("");
+  stats.received(1, false);
+  stats.sent("+CIPSEND=2,", 10);
+  stats.received(1, true);
+  CHECK_EQ(stats.commands(), 3);
+  CHECK_STR(stats.command(0).name, "+CIPSEND");
+  CHECK_STR(stats.command(1).name, "+CIPSTATUS");
+  CHECK_STR(stats.command(2).name, "AT");
+  CHECK_EQ(stats.find("+CIPSEND")->count, 2);
+  CHECK_EQ(stats.find("+CIPSEND")->errors, 1);
+  CHECK(stats.find("+CSQ") == NULL);
+}
+
+// Only the first response after a command counts, a missing one is a timeout
+static void testLatency()
+{
+  TinyGsmStats stats;
+  stats.sent("+CSQ");
+  stats.received(1, false);
+  stats.received(1, false);
+  stats.sent("+CSQ");
+  delay(20);
+  stats.received(1, false);
+  stats.sent("+CSQ");
+  stats.received(0, false);
+
+  const TinyGsmCommandStats* c = stats.find("+CSQ");
+  CHECK_EQ(c->count, 2);
+  CHECK_EQ(c->timeouts, 1);
+  CHECK(c->min <= 1);
+  CHECK(c->max >= 20 && c->max < 100);
+  CHECK_EQ(c->avg(), c->total / 2);
+  // 20 ms falls into [16, 32)
+  CHECK(c->percentile(50) <= 1);
+  CHECK_EQ(c->percentile(99), TinyGsmMin(31UL, (unsigned long)c->max));
+}
+
+// Commands past the table are not counted
+static void testTableFull()
+{
+  TinyGsmStats stats;
+  char name[8];
+  for (int i = 0; i < TINY_GSM_STATS_COMMANDS + 2; i++) {
+    sprintf(name, "+C%d", i);
+    stats.sent(name);
+    stats.received(1, false);
+  }
+  CHECK_EQ(stats.commands(), TINY_GSM_STATS_COMMANDS);
+  CHECK(stats.find("+C0") != NULL);
+  CHECK(stats.find("+C9") == NULL);
+  stats.reset();
+  CHECK_EQ(stats.commands(), 0);
+}
+
+static void testModem()
+{
+  fake.reset();
+  fake.onUnknown("\r\nOK\r\n");
+  fake.on("AT+CSQ", "\r\n+CSQ: 20,0\r\n\r\nOK\r\n");
+  fake.on("AT+ICCID", "\r\nERROR\r\n");
+  fake.on("AT+GSN", "");  // No answer
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+  fake.on("AT+CIPSTART=", "\r\nOK\r\n\r\n1, CONNECT OK\r\n");
+  fake.on("AT+CIPSEND=", [](FakeModem& m, const char* cmd) {
+    unsigned mux, len;
+    sscanf(cmd, "AT+CIPSEND=%u,%u", &mux, &len);
+    m.reply("> ");
+    m.receiveData(len, [mux](FakeModem& m, const uint8_t* data, size_t len) {
+      char buf[40];
+      sprintf(buf, "\r\n%u, SEND OK\r\n", mux);
+      m.reply(buf);
+    });
+  });
+  fake.on("AT+CIPRXGET=2,1,", "\r\n+CIPRXGET: 2,1,5,0\r\nhello\r\nOK\r\n");
+  fake.on("AT+CIPRXGET=4,1", "\r\n+CIPRXGET: 4,1,5\r\n\r\nOK\r\n");
+
+  TinyGsm modem(fake);
+  TinyGsmStats& stats = modem.getStats();
+  CHECK_EQ(modem.getSignalQuality(), 20);
+  CHECK_EQ(modem.getSignalQuality(), 20);
+  CHECK_STR(modem.getSimCCID().c_str(), "");
+  CHECK_EQ(stats.find("+CSQ")->count, 2);
+  CHECK_EQ(stats.find("+CSQ")->errors, 0);
+  CHECK_EQ(stats.find("+ICCID")->errors, 1);
+  CHECK_EQ(stats.find("+ICCID")->count, 1);
+  CHECK_STR(modem.getIMEI().c_str(), "");
+  CHECK_EQ(stats.find("+GSN")->timeouts, 1);
+  CHECK_EQ(stats.find("+GSN")->count, 0);
+
+  TinyGsmClient client(modem, 1);
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(client.write((const uint8_t*)"hello", 5), 5);
+  client.flush();
+  CHECK_EQ(stats.txBytes(1), 5);
+  fake.reply("\r\n+CIPRXGET: 1,1\r\n");
+  char buf[8] = { 0 };
+  CHECK_EQ(client.read((uint8_t*)buf, 5), 5);
+  CHECK_EQ(stats.rxBytes(1), 5);
+  CHECK_EQ(stats.txBytes(0), 0);
+  CHECK_EQ(stats.rxBytes(TINY_GSM_MUX_COUNT), 0);
+  CHECK(stats.find("+CIPSTART") != NULL);
+}
+
+int main()
+{
+  RUN(testNames);
+  RUN(testLatency);
+  RUN(testTableFull);
+  RUN(testModem);
+  return testResult();
+}
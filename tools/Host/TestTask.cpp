@@ -0,0 +1,127 @@
+/**
+ * @file       TestTask.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * TinyGsmTask and TinyGsmProxyClient: data through the modem thread, a
+ * send failure ending a write() that waits for room, and requests made
+ * while the task does not run.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#include <TinyGsmClient.h>
+#include <TinyGsmTask.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+#include <string>
+
+static FakeModem fake;
+static std::string sent;
+static bool fail;
+
+// Only the modem thread touches fake once the task runs
+static void script()
+{
+  fake.reset();
+  sent.clear();
+  fake.onUnknown("\r\nOK\r\n");
+  fake.on("AT+CIPQSEND?", "\r\n+CIPQSEND: 1\r\n\r\nOK\r\n");
+  fake.on("AT+CIPCLOSE=", "\r\nERROR\r\n");
+  fake.on("AT+CIPSTART=", "\r\nOK\r\n\r\n1, CONNECT OK\r\n");
+  fake.on("AT+CIPSEND=", [](FakeModem& m, const char* cmd) {
+    unsigned mux, len;
+    sscanf(cmd, "AT+CIPSEND=%u,%u", &mux, &len);
+    m.reply("> ");
+    m.receiveData(len, [mux](FakeModem& m, const uint8_t* data, size_t len) {
+      char buf[40];
+      sent.append((const char*)data, len);
+      if (fail) {
+        sprintf(buf, "\r\n%u, SEND FAIL\r\n", mux);
+      } else {
+        sprintf(buf, "\r\nDATA ACCEPT:%u,%u\r\n", mux, (unsigned)len);
+      }
+      m.reply(buf);
+    });
+  });
+}
+
+static void testWrite()
+{
+  fail = false;
+  script();
+  TinyGsm modem(fake);
+  TinyGsmTask<TinyGsm> task(modem);
+  TinyGsmProxyClient client;
+  CHECK(task.attach(client, 1));
+  CHECK(task.begin());
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(client.write((const uint8_t*)"hello", 5), 5);
+  client.flush();
+  CHECK_EQ(client.getWriteError(), 0);
+  CHECK(client.connected());
+  task.end();
+  CHECK_STR(sent.c_str(), "hello");
+}
+
+// More than the proxy buffer holds, so write() waits for the modem task
+static void testSendFail()
+{
+  fail = true;
+  script();
+  TinyGsm modem(fake);
+  TinyGsmTask<TinyGsm> task(modem);
+  TinyGsmProxyClient client;
+  CHECK(task.attach(client, 1));
+  CHECK(task.begin());
+  CHECK(client.connect("example.com", 80));
+
+  static uint8_t data[4 * TINY_GSM_PROXY_BUFFER];
+  memset(data, 'x', sizeof(data));
+  size_t n = client.write(data, sizeof(data));
+  CHECK(n < sizeof(data));
+  CHECK(client.getWriteError());
+  CHECK_EQ(client.write((const uint8_t*)"more", 4), 0);
+  client.flush();
+  client.stop();
+  CHECK(!client.connected());
+
+  // A new connection starts without the error
+  fail = false;
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(client.getWriteError(), 0);
+  task.end();
+}
+
+// Without the modem task nobody would answer, so these return at once
+static void testNotRunning()
+{
+  script();
+  TinyGsm modem(fake);
+  TinyGsmTask<TinyGsm> task(modem);
+  TinyGsmProxyClient client;
+  CHECK(!client.connect("example.com", 80));
+  CHECK(task.attach(client, 1));
+  CHECK(!client.connect("example.com", 80));
+  client.flush();
+  client.stop();
+  CHECK_EQ(fake.commands(), 0);
+
+  CHECK(task.begin());
+  CHECK(client.connect("example.com", 80));
+  task.end();
+  CHECK(!client.connect("example.com", 80));
+  CHECK_EQ(client.write((const uint8_t*)"hi", 2), 0);
+  client.flush();
+  client.stop();
+}
+
+int main()
+{
+  RUN(testWrite);
+  RUN(testSendFail);
+  RUN(testNotRunning);
+  return testResult();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file       TestTrace.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * TinyGsmTrace: one mark per burst and direction, escaping of 0xFF, and
+ * the timeout reaching the wrapped stream.
+ */
+
+#include "Arduino.h"
+#include <TinyGsmTrace.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+
+// Marks of kind dir in a buffer that has not wrapped yet
+template<size_t N>
+static int marks(const TinyGsmTraceBuffer<N>& buf, uint8_t dir)
+{
+  int found = 0;
+  for (uint32_t i = 0; i + 1 < buf.state.head && i + 1 < N; i++) {
+    if (buf.data[i] == TINY_GSM_TRACE_ESC) {
+      found += buf.data[i + 1] == dir;
+      i++;
+    }
+  }
+  return found;
+}
+
+static void testBurst()
+{
+  static TinyGsmTraceBuffer<1024> buf;
+  fake.reset();
+  fake.onUnknown("\r\nOK\r\n");
+  buf.state.magic = 0;
+  TinyGsmTrace trace(fake, buf);
+  CHECK(!trace.restored());
+
+  uint8_t cmd[200];
+  memset(cmd, 'A', sizeof(cmd));
+  cmd[sizeof(cmd) - 2] = '\r';
+  cmd[sizeof(cmd) - 1] = '\n';
+  CHECK_EQ(trace.write(cmd, sizeof(cmd)), sizeof(cmd));
+  CHECK_EQ(marks(buf, TINY_GSM_TRACE_TX), 1);
+  CHECK_EQ(marks(buf, TINY_GSM_TRACE_SYNC), 1);
+
+  char reply[8] = { 0 };
+  trace.setTimeout(10);
+  CHECK_EQ(trace.readBytes(reply, 6), 6);
+  CHECK_STR(reply, "\r\nOK\r\n");
+  CHECK_EQ(marks(buf, TINY_GSM_TRACE_RX), 1);
+  // Sync, TX mark, command, RX mark, reply
+  CHECK_EQ(trace.size(), 6 + 4 + sizeof(cmd) + 4 + 6);
+}
+
+static void testEscape()
+{
+  static TinyGsmTraceBuffer<64> buf;
+  fake.reset();
+  buf.state.magic = 0;
+  TinyGsmTrace trace(fake, buf);
+  trace.write(0xFF);
+  uint32_t n = buf.state.head;
+  CHECK_EQ(buf.data[n - 2], 0xFF);
+  CHECK_EQ(buf.data[n - 1], 0x00);
+}
+
+// The wrapped stream does the waiting in readBytes()
+static void testTimeout()
+{
+  static TinyGsmTraceBuffer<64> buf;
+  fake.reset();
+  buf.state.magic = 0;
+  TinyGsmTrace trace(fake, buf);
+  trace.setTimeout(50);
+  CHECK_EQ(fake.getTimeout(), 50);
+
+  Stream& s = trace;
+  s.setTimeout(20);
+  char c;
+  unsigned long start = millis();
+  CHECK_EQ(trace.readBytes(&c, 1), 0);
+  CHECK(millis() - start < 45);
+  CHECK_EQ(fake.getTimeout(), 20);
+}
+
+int main()
+{
+  RUN(testBurst);
+  RUN(testEscape);
+  RUN(testTimeout);
+  return testResult();
+}
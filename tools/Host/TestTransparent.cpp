@@ -0,0 +1,84 @@
+/**
+ * @file       TestTransparent.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * SIM800 transparent mode: payload that arrives while the modem takes the
+ * +++ escape is kept, and polling the client does not return to data mode.
+ */
+
+#define TINY_GSM_MODEM_SIM800
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+static int resumed;
+
+static void script(const char* escaped)
+{
+  fake.reset();
+  resumed = 0;
+  fake.onUnknown("\r\nOK\r\n");
+  fake.on("AT+CIPSTART=", "\r\nOK\r\n\r\nCONNECT\r\n");
+  fake.on("AT+CSQ", "\r\n+CSQ: 20,0\r\n\r\nOK\r\n");
+  fake.on("ATO", [](FakeModem& m, const char* cmd) {
+    resumed++;
+    m.reply("\r\nCONNECT\r\nmore");
+  });
+  // The modem still forwards some payload before it takes the escape
+  fake.on("+++", [escaped](FakeModem& m, const char* cmd) {
+    m.reply(escaped);
+    m.reply("\r\nOK\r\n");
+  });
+}
+
+static void testEscape()
+{
+  script("late\r\nOK\rdata");
+  TinyGsm modem(fake);
+  TinyGsmClientTransparent client(modem);
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(modem.getSignalQuality(), 20);
+
+  // Polling only reports what is there
+  CHECK_EQ(client.available(), 13);
+  CHECK_EQ(client.peek(), 'l');
+  CHECK(client.connected());
+  CHECK_EQ(resumed, 0);
+
+  char buf[16] = { 0 };
+  CHECK_EQ(client.read((uint8_t*)buf, 13), 13);
+  CHECK_STR(buf, "late\r\nOK\rdata");
+  CHECK_EQ(resumed, 0);
+
+  // Reading on returns to data mode
+  memset(buf, 0, sizeof(buf));
+  CHECK_EQ(client.read((uint8_t*)buf, 4), 4);
+  CHECK_STR(buf, "more");
+  CHECK_EQ(resumed, 1);
+}
+
+static void testEscapeNoPayload()
+{
+  script("");
+  TinyGsm modem(fake);
+  TinyGsmClientTransparent client(modem);
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(modem.getSignalQuality(), 20);
+  CHECK_EQ(client.available(), 0);
+  CHECK_EQ(client.peek(), -1);
+  CHECK_EQ(resumed, 0);
+  CHECK_EQ(client.write((const uint8_t*)"hi", 2), 2);
+  CHECK_EQ(resumed, 1);
+  CHECK_EQ(client.available(), 4);
+}
+
+int main()
+{
+  RUN(testEscape);
+  RUN(testEscapeNoPayload);
+  return testResult();
+}
@@ -0,0 +1,115 @@
+/**
+ * @file       TestTxBuffer.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Collected writes (TinyGsmTxBuffer): a failed send of the buffer must
+ * surface as a write error instead of vanishing, and nothing is collected
+ * for a socket that is not connected.
+ */
+
+#define TINY_GSM_MODEM_BG96
+#include <TinyGsmClient.h>
+#include "FakeModem.h"
+#include "HostTest.h"
+
+static FakeModem fake;
+static std::string sent;
+
+static void script(bool accept)
+{
+  fake.reset();
+  sent.clear();
+  fake.on("AT+QICLOSE=", "\r\nOK\r\n");
+  fake.on("AT+QIOPEN=", "\r\nOK\r\n\r\n+QIOPEN: 1,0\r\n");
+  fake.on("AT+QISTATE", "\r\nOK\r\n");
+  fake.on("AT+QIRD=", "\r\n+QIRD: 0\r\n\r\nOK\r\n");
+  fake.on("AT+QISEND=", [accept](FakeModem& m, const char* cmd) {
+    unsigned mux, len;
+    sscanf(cmd, "AT+QISEND=%u,%u", &mux, &len);
+    if (!accept) {
+      m.reply("\r\nERROR\r\n");
+      return;
+    }
+    m.reply("\r\n> ");
+    m.receiveData(len, [](FakeModem& m, const uint8_t* data, size_t len) {
+      sent.append((const char*)data, len);
+      m.reply("\r\nSEND OK\r\n");
+    });
+  });
+}
+
+static void testCollected()
+{
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  script(true);
+  CHECK(client.connect("example.com", 80));
+  unsigned long before = fake.commands();
+  client.print("GET / HTTP/1.0");
+  client.print("\r\n\r\n");
+  CHECK_EQ(fake.commands(), before);
+  client.flush();
+  CHECK_EQ(fake.commands(), before + 1);
+  CHECK_STR(sent.c_str(), "GET / HTTP/1.0\r\n\r\n");
+  CHECK_EQ(client.getWriteError(), 0);
+}
+
+static void testSendFails()
+{
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  script(false);
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(client.write((const uint8_t*)"hello", 5), 5);
+  client.flush();
+  CHECK(client.getWriteError() != 0);
+  // Later writes fail until the next connect
+  CHECK_EQ(client.write((const uint8_t*)"more", 4), 0);
+  script(true);
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(client.getWriteError(), 0);
+  CHECK_EQ(client.write((const uint8_t*)"again", 5), 5);
+  client.flush();
+  CHECK_STR(sent.c_str(), "again");
+}
+
+static void testClosedMeanwhile()
+{
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  script(true);
+  CHECK(client.connect("example.com", 80));
+  CHECK_EQ(client.write((const uint8_t*)"hello", 5), 5);
+  fake.reply("\r\n+QIURC: \"closed\",1\r\n");
+  modem.maintain();
+  CHECK_EQ(client.getWriteError(), 0);
+  client.flush();
+  CHECK(client.getWriteError() != 0);
+  CHECK(sent.empty());
+}
+
+static void testNotConnected()
+{
+  TinyGsm modem(fake);
+  TinyGsmClient client(modem, 1);
+  script(true);
+  CHECK_EQ(client.write((const uint8_t*)"hello", 5), 0);
+  CHECK(client.connect("example.com", 80));
+  fake.reply("\r\n+QIURC: \"closed\",1\r\n");
+  modem.maintain();
+  CHECK_EQ(client.write((const uint8_t*)"hello", 5), 0);
+  client.flush();
+  CHECK(sent.empty());
+}
+
+int main()
+{
+  RUN(testCollected);
+  RUN(testSendFails);
+  RUN(testClosedMeanwhile);
+  RUN(testNotConnected);
+  return testResult();
+}
@@ -0,0 +1,142 @@
+/**
+ * @file       TraceDecode.cpp
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Decodes TinyGsmTrace::dump() output, as captured from the serial console,
+ * into the AT traffic as AT_Spy shows it.
+ *
+ *   trace_decode [-t] [file]
+ *
+ *   -t   start every burst on a new line with its time and direction:
+ *        "[     12.345] >> " for sent, "[     12.345] << " for received bytes.
+ *        Times before the first sync in the dump are relative ("+").
+ *
+ * Lines outside "#TinyGsmTrace" ... "#end" are skipped, so the whole
+ * console log can be fed in.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+static bool timestamps = false;
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+static void decode(const std::vector<uint8_t>& t) {
+  size_t i = 0;
+  // The oldest bytes may start within a burst, skip to the first mark
+  while (i + 1 < t.size() && !(t[i] == 0xFF && t[i + 1] != 0x00)) i++;
+
+  uint32_t time = 0;
+  bool synced = false;
+  bool lineStart = true;
+  while (i < t.size()) {
+    uint8_t b = t[i++];
+    if (b != 0xFF) {
+      putchar(b);
+      lineStart = (b == '\n');
+      continue;
+    }
+    if (i >= t.size()) break;
+    uint8_t tag = t[i++];
+    switch (tag) {
+    case 0x00:
+      putchar(0xFF);
+      lineStart = false;
+      break;
+    case 0x01:
+    case 0x02:
+      if (i + 2 > t.size()) return;
+      time += t[i] | (t[i + 1] << 7);
+      i += 2;
+      if (timestamps) {
+        if (!lineStart) putchar('\n');
+        printf("[%c%7u.%03u] %s ", synced ? ' ' : '+', time / 1000, time % 1000,
+               tag == 0x01 ? ">>" : "<<");
+        lineStart = false;
+      }
+      break;
+    case 0x03:
+      if (i + 4 > t.size()) return;
+      time = t[i] | (t[i + 1] << 7) | (t[i + 2] << 14) | ((uint32_t)t[i + 3] << 21);
+      i += 4;
+      synced = true;
+      break;
+    case 0x04:
+      if (!lineStart) putchar('\n');
+      printf("--- restart ---\n");
+      lineStart = true;
+      synced = false;
+      time = 0;
+      break;
+    default:
+      fprintf(stderr, "Bad mark %02X at %u\n", tag, (unsigned)(i - 2));
+      return;
+    }
+  }
+  if (timestamps && !lineStart) putchar('\n');
+}
+
+int main(int argc, char* argv[]) {
+  const char* path = NULL;
+  for (int a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "-t")) {
+      timestamps = true;
+    } else if (argv[a][0] == '-') {
+      fprintf(stderr, "Usage: %s [-t] [file]\n", argv[0]);
+      return 2;
+    } else {
+      path = argv[a];
+    }
+  }
+  FILE* in = path ? fopen(path, "r") : stdin;
+  if (!in) {
+    perror(path);
+    return 1;
+  }
+
+  std::vector<uint8_t> trace;
+  bool inside = false;
+  int found = 0;
+  char line[4096];
+  while (fgets(line, sizeof(line), in)) {
+    const char* p = strstr(line, "#TinyGsmTrace");
+    if (p) {
+      trace.clear();
+      inside = true;
+      continue;
+    }
+    if (!inside) continue;
+    if (strstr(line, "#end")) {
+      decode(trace);
+      inside = false;
+      found++;
+      continue;
+    }
+    for (p = line; p[0] && p[1]; ) {
+      int hi = hexValue(p[0]), lo = hexValue(p[1]);
+      if (hi < 0 || lo < 0) {
+        p++;
+        continue;
+      }
+      trace.push_back((uint8_t)(hi << 4 | lo));
+      p += 2;
+    }
+  }
+  if (path) fclose(in);
+  if (!found) {
+    fprintf(stderr, "No trace found\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file       WString.h
+ * @author     Volodymyr Shymanskyy
+ * @license    LGPL-3.0
+ * @copyright  Copyright (c) 2016 Volodymyr Shymanskyy
+ * @date       Oct 2026
+ *
+ * Heap-backed String with the same API and allocation behaviour as the
+ * Arduino core one, so host measurements reflect what boards do.
+ */
+
+#ifndef String_class_h
+#define String_class_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Incremented on every String buffer (re)allocation
+extern unsigned long TinyGsmHostStringAllocs;
+
+class String
+{
+public:
+  String(const char *cstr = "");
+  String(const char *cstr, unsigned int length);
+  String(const String &str);
+  String(String &&rval);
+  explicit String(char c);
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimalPlaces = 2);
+  explicit String(double value, unsigned char decimalPlaces = 2);
+  ~String();
+
+  bool reserve(unsigned int size);
+  unsigned int length() const { return len; }
+
+  String& operator = (const String &rhs);
+  String& operator = (const char *cstr);
+  String& operator = (String &&rval);
+
+  bool concat(const String &str);
+  bool concat(const char *cstr);
+  bool concat(const char *cstr, unsigned int length);
+  bool concat(char c);
+  bool concat(unsigned char num);
+  bool concat(int num);
+  bool concat(unsigned int num);
+  bool concat(long num);
+  bool concat(unsigned long num);
+  bool concat(float num);
+  bool concat(double num);
+
+  template <typename T>
+  String& operator += (const T &rhs) { concat(rhs); return *this; }
+  String& operator += (const char *cstr) { concat(cstr); return *this; }
+
+  explicit operator bool() const { return buffer != NULL; }
+
+  int compareTo(const String &s) const;
+  bool equals(const String &s) const;
+  bool equals(const char *cstr) const;
+  bool operator == (const String &rhs) const { return equals(rhs); }
+  bool operator == (const char *cstr) const { return equals(cstr); }
+  bool operator != (const String &rhs) const { return !equals(rhs); }
+  bool operator != (const char *cstr) const { return !equals(cstr); }
+  bool operator <  (const String &rhs) const { return compareTo(rhs) < 0; }
+  bool equalsIgnoreCase(const String &s) const;
+  bool startsWith(const String &prefix) const;
+  bool startsWith(const String &prefix, unsigned int offset) const;
+  bool endsWith(const String &suffix) const;
+
+  char charAt(unsigned int index) const;
+  void setCharAt(unsigned int index, char c);
+  char operator [] (unsigned int index) const;
+  char& operator [] (unsigned int index);
+  void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const;
+  void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const
+    { getBytes((unsigned char *)buf, bufsize, index); }
+  const char* c_str() const { return buffer; }
+  char* begin() { return buffer; }
+  char* end() { return buffer + len; }
+
+  int indexOf(char ch) const;
+  int indexOf(char ch, unsigned int fromIndex) const;
+  int indexOf(const String &str) const;
+  int indexOf(const String &str, unsigned int fromIndex) const;
+  int lastIndexOf(char ch) const;
+  int lastIndexOf(char ch, unsigned int fromIndex) const;
+  int lastIndexOf(const String &str) const;
+  int lastIndexOf(const String &str, unsigned int fromIndex) const;
+  String substring(unsigned int beginIndex) const { return substring(beginIndex, len); }
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+  void replace(char find, char replace);
+  void replace(const String &find, const String &replace);
+  void remove(unsigned int index);
+  void remove(unsigned int index, unsigned int count);
+  void toLowerCase();
+  void toUpperCase();
+  void trim();
+
+  long toInt() const;
+  float toFloat() const;
+  double toDouble() const;
+
+protected:
+  char *buffer;
+  unsigned int capacity;
+  unsigned int len;
+
+  void init();
+  void invalidate();
+  bool changeBuffer(unsigned int maxStrLen);
+  String& copy(const char *cstr, unsigned int length);
+  void move(String &rhs);
+};
+
+template <typename T>
+String operator + (String lhs, const T &rhs) { lhs.concat(rhs); return lhs; }
+String operator + (const char *lhs, const String &rhs);
+
+#endif